@@ -0,0 +1,65 @@
+#pragma once
+#include <zcc_core/Util.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+
+
+namespace Zero::Bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr uint64 DefaultSeed = 0x5EED5EED5EED5EED;
+
+	struct Measurement
+	{
+		double seconds;
+		uint64 cycles; // Time stamp counter ticks, which run at the nominal clock rate whatever the core's current one is.
+	};
+
+	// Runs fn the given number of times and returns the fastest run.
+	template <typename F>
+	Measurement Measure(F&& fn, uint32 repetitions = 5)
+	{
+		Measurement r = { DBL_MAX, UINT64_MAX };
+		for (uint32 i = 0; i != repetitions; ++i)
+		{
+			auto c0 = __rdtsc();
+			auto t0 = Clock::now();
+			fn();
+			auto t1 = Clock::now();
+			auto c1 = __rdtsc();
+			r.seconds = std::min(r.seconds, std::chrono::duration<double>(t1 - t0).count());
+			r.cycles = std::min<uint64>(r.cycles, c1 - c0);
+		}
+		return r;
+	}
+
+	template <typename F>
+	double MeasureSeconds(F&& fn, uint32 repetitions = 5)
+	{
+		return Measure(std::forward<F>(fn), repetitions).seconds;
+	}
+
+	// Keeps the optimizer from discarding a benchmarked result.
+	template <typename T>
+	void DoNotOptimize(const T& value)
+	{
+		static volatile uint64 sink;
+		sink = sink + (uint64)value;
+	}
+
+	void Keywords();
+	void ParallelLexing();
+	void LexerThroughput(uintptr max_size);
+	void ParserReuse();
+	void ParallelParsing();
+	void IncrementalReparse();
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "Bench.hpp"
+#include <zcc_core/Keyword.hpp>
+
+
+
+namespace Zero::Bench
+{
+	// The HashMap-based lookup IsKeyword used before it switched to a perfect hash, kept as the baseline.
+	static Keyword IsKeywordHashMap(string_view token)
+	{
+		static const auto lookup = []
+		{
+			HashMap<string_view, Keyword> r = {};
+			for (uint8 i = 0; i != (uint8)Keyword::MaxEnum; ++i)
+				r.insert({ KEYWORD_STRINGS[i], (Keyword)i });
+			return r;
+		}();
+
+		static const auto sizes = std::minmax_element(
+			std::begin(KEYWORD_STRINGS), std::end(KEYWORD_STRINGS),
+			[](string_view lhs, string_view rhs) { return lhs.size() < rhs.size(); });
+
+		if (token.size() < sizes.first->size() || token.size() > sizes.second->size())
+			return Keyword::MaxEnum;
+		auto it = lookup.find(token);
+		if (it != lookup.end())
+			return it->second;
+		return Keyword::MaxEnum;
+	}
+
+	// Identifier-heavy corpus: mostly keyword-sized identifiers, many sharing a prefix or suffix with a keyword, and about one keyword in five.
+	static vector<string> MakeIdentifierCorpus(uintptr count)
+	{
+		static constexpr char Alphabet[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+
+		std::mt19937_64 rng(DefaultSeed);
+		vector<string> r;
+		r.reserve(count);
+		for (uintptr i = 0; i != count; ++i)
+		{
+			auto keyword = string(KEYWORD_STRINGS[rng() % std::size(KEYWORD_STRINGS)]);
+			switch (rng() % 5)
+			{
+			case 0:
+				r.push_back(std::move(keyword));
+				break;
+			case 1:
+				keyword.back() = Alphabet[rng() % 26];
+				r.push_back(std::move(keyword));
+				break;
+			case 2:
+				r.push_back(keyword + Alphabet[rng() % (sizeof(Alphabet) - 1)]);
+				break;
+			default:
+			{
+				string e(1 + rng() % 12, '\0');
+				for (auto& c : e)
+					c = Alphabet[rng() % 26];
+				r.push_back(std::move(e));
+				break;
+			}
+			}
+		}
+		return r;
+	}
+
+	void Keywords()
+	{
+		constexpr uintptr Count = 1 << 20;
+
+		auto corpus = MakeIdentifierCorpus(Count);
+		vector<string_view> tokens(corpus.begin(), corpus.end());
+
+		for (auto& e : tokens)
+		{
+			if (IsKeyword(e) != IsKeywordHashMap(e))
+			{
+				printf("IsKeyword mismatch on \"%.*s\".\n", (int)e.size(), e.data());
+				return;
+			}
+		}
+
+		auto run = [&](const char* name, auto&& fn)
+		{
+			auto seconds = MeasureSeconds([&]
+			{
+				uint64 hits = 0;
+				for (auto& e : tokens)
+					hits += fn(e) != Keyword::MaxEnum;
+				DoNotOptimize(hits);
+			});
+			printf("%-24s %8.2f ns/token %10.2f Mtokens/s\n", name, seconds * 1e9 / Count, Count / seconds * 1e-6);
+		};
+
+		printf("--- Keyword lookup, %zu identifiers ---\n", (size_t)Count);
+		run("HashMap", IsKeywordHashMap);
+		run("Perfect hash", [](string_view token) { return IsKeyword(token); });
+	}
+}
\ No newline at end of file
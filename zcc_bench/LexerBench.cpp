@@ -0,0 +1,206 @@
+#include "Bench.hpp"
+#include <zcc_core/Tokenizer.hpp>
+#include <zcc_core/SourceFile.hpp>
+
+
+
+namespace Zero::Bench
+{
+	enum class CorpusKind : uint8
+	{
+		Identifiers,
+		Operators,
+		Comments,
+		Literals,
+
+		MaxEnum
+	};
+
+	constexpr string_view CORPUS_NAMES[] = { "identifiers", "operators", "comments", "literals" };
+
+	static string RandomName(std::mt19937_64& rng)
+	{
+		static constexpr char Alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+		string r(1 + rng() % 12, '\0');
+		for (auto& c : r)
+			c = Alphabet[rng() % 53]; // No digits, so the name can't start with one.
+		if (rng() % 2 == 0)
+			r += Alphabet[rng() % (sizeof(Alphabet) - 1)];
+		return r;
+	}
+
+	// One line of the given kind of corpus.
+	static void AppendLine(CorpusKind kind, std::mt19937_64& rng, string& out)
+	{
+		switch (kind)
+		{
+		case CorpusKind::Identifiers:
+			// Names and keywords separated by spaces and commas, as in declaration-heavy code.
+			for (auto i = 4 + rng() % 8; i != 0; --i)
+			{
+				if (rng() % 8 == 0)
+					out += KEYWORD_STRINGS[rng() % std::size(KEYWORD_STRINGS)];
+				else
+					out += RandomName(rng);
+				out += rng() % 4 == 0 ? ", " : " ";
+			}
+			break;
+		case CorpusKind::Operators:
+			// Every fixed spelling, mostly without spaces, with a few one-letter operands in between.
+			for (auto i = 8 + rng() % 16; i != 0; --i)
+			{
+				out += OPERATOR_SPELLINGS[rng() % std::size(OPERATOR_SPELLINGS)].text;
+				if (rng() % 3 == 0)
+				{
+					out += ' ';
+					out += (char)('a' + rng() % 26);
+					out += ' ';
+				}
+			}
+			break;
+		case CorpusKind::Comments:
+			// Line and block comments, some of them long, with the odd statement in between.
+			switch (rng() % 4)
+			{
+			case 0:
+				out += "x = y + 1 ";
+				[[fallthrough]];
+			case 1:
+				out += "``";
+				for (auto i = rng() % 16; i != 0; --i)
+					out += RandomName(rng) + ' ';
+				break;
+			default:
+				out += '`';
+				for (auto i = rng() % 64; i != 0; --i)
+					out += RandomName(rng) + (rng() % 8 == 0 ? '\n' : ' ');
+				out += '`';
+				break;
+			}
+			break;
+		case CorpusKind::Literals:
+			// Numbers in every radix, reals, chars and strings, a few of them with escapes.
+			for (auto i = 2 + rng() % 6; i != 0; --i)
+			{
+				char buffer[64];
+				switch (rng() % 6)
+				{
+				case 0:
+					out += std::to_string(rng() % 1000000);
+					break;
+				case 1:
+					(void)snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)rng());
+					out += buffer;
+					break;
+				case 2:
+					out += "0b";
+					for (auto j = 1 + rng() % 32; j != 0; --j)
+						out += (char)('0' + rng() % 2);
+					break;
+				case 3:
+					(void)snprintf(buffer, sizeof(buffer), "%.*f", (int)(1 + rng() % 8), (double)(rng() % 100000) / 7.0);
+					out += buffer;
+					break;
+				case 4:
+					out += rng() % 4 == 0 ? "'\\n'" : string{ '\'', (char)('a' + rng() % 26), '\'' };
+					break;
+				default:
+					out += '"';
+					for (auto j = rng() % 48; j != 0; --j)
+						out += rng() % 32 == 0 ? "\\t" : string(1, (char)('a' + rng() % 26));
+					out += '"';
+					break;
+				}
+				out += ", ";
+			}
+			break;
+		default:
+			break;
+		}
+		out += '\n';
+	}
+
+	// Whole lines up to size bytes, the same ones for a given kind on every run, followed by SOURCE_PADDING NUL bytes.
+	static string MakeCorpus(CorpusKind kind, uintptr size)
+	{
+		std::mt19937_64 rng(DefaultSeed + (uint64)kind);
+		string r;
+		r.reserve(size + SOURCE_PADDING + 4096);
+		while (r.size() < size)
+			AppendLine(kind, rng, r);
+		r.resize(r.rfind('\n', size) + 1);
+		r.append(SOURCE_PADDING, '\0');
+		return r;
+	}
+
+	// The loop TokenStream::Lex runs, minus storing the tokens.
+	static uintptr LexAll(string_view text, bool padded, IdentifierTable& identifiers)
+	{
+		Tokenizer tokenizer(text, padded);
+		tokenizer.identifiers = &identifiers;
+		TokenData data;
+		uintptr count = 0;
+		while (true)
+		{
+			tokenizer.SkipCommentsAndWhitespace();
+			if (tokenizer.cursor >= tokenizer.end)
+				break;
+			(void)tokenizer.NextToken(data);
+			++count;
+		}
+		return count;
+	}
+
+	void LexerThroughput(uintptr max_size)
+	{
+		constexpr uintptr MinBytesPerRun = 64 << 20; // Small corpora are lexed repeatedly per run, so a run is long enough to time.
+
+		vector<uintptr> sizes;
+		for (uintptr size = 1 << 10; size < max_size; size *= 32)
+			sizes.push_back(size);
+		sizes.push_back(max_size);
+
+		printf("--- Lexer throughput ---\n");
+		printf("%-12s %10s %-8s %10s %12s %12s\n", "corpus", "bytes", "mode", "MB/s", "Mtokens/s", "cycles/byte");
+		for (uint8 kind = 0; kind != (uint8)CorpusKind::MaxEnum; ++kind)
+		{
+			auto corpus = MakeCorpus((CorpusKind)kind, max_size);
+			auto corpus_size = corpus.size() - SOURCE_PADDING;
+			for (auto size : sizes)
+			{
+				// Smaller corpora are prefixes of the biggest one, cut after a newline and padded again.
+				string prefix;
+				string_view text(corpus.data(), corpus_size);
+				if (size < corpus_size)
+				{
+					prefix.assign(corpus, 0, corpus.rfind('\n', size) + 1);
+					prefix.append(SOURCE_PADDING, '\0');
+					text = string_view(prefix.data(), prefix.size() - SOURCE_PADDING);
+				}
+
+				auto passes = std::max<uintptr>(MinBytesPerRun / std::max<uintptr>(text.size(), 1), 1);
+				for (auto padded : { false, true })
+				{
+					IdentifierTable identifiers;
+					uintptr tokens = 0;
+					auto m = Measure([&]
+					{
+						tokens = 0;
+						for (uintptr i = 0; i != passes; ++i)
+						{
+							identifiers.Clear();
+							tokens += LexAll(text, padded, identifiers);
+						}
+					}, 3);
+
+					auto bytes = (double)text.size() * passes;
+					printf("%-12.*s %10zu %-8s %10.2f %12.2f %12.3f\n",
+						(int)CORPUS_NAMES[kind].size(), CORPUS_NAMES[kind].data(), (size_t)text.size(),
+						padded ? "padded" : "checked",
+						bytes / m.seconds * 1e-6, tokens / m.seconds * 1e-6, m.cycles / bytes);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "Bench.hpp"
+
+
+
+int main(int argc, char** args)
+{
+	using namespace Zero::Bench;
+
+	auto selected = [&](const char* name)
+	{
+		return argc < 2 || strcmp(args[1], name) == 0;
+	};
+
+	if (selected("keywords"))
+		Keywords();
+	if (selected("parallel-lexing"))
+		ParallelLexing();
+	if (selected("lexer"))
+		LexerThroughput(argc >= 3 ? (Zero::uintptr)strtoull(args[2], nullptr, 10) << 20 : 1 << 30); // Optional largest corpus, in MB.
+	if (selected("parser-reuse"))
+		ParserReuse();
+	if (selected("parallel-parsing"))
+		ParallelParsing();
+	if (selected("reparse"))
+		IncrementalReparse();
+	return 0;
+}
\ No newline at end of file
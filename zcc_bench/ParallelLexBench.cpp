@@ -0,0 +1,84 @@
+#include "Bench.hpp"
+#include <zcc_core/TokenStream.hpp>
+#include <thread>
+
+
+
+namespace Zero::Bench
+{
+	// Function-sized blocks of declarations, expressions and comments, the shape of our generated sources.
+	static string MakeGeneratedSource(uintptr size)
+	{
+		static constexpr string_view Names[] = { "value", "count", "index", "buffer", "result", "node", "left", "right" };
+		static constexpr string_view Operators[] = { "+", "-", "*", "<<", "&", "|", "==", "!=", "<=" };
+
+		std::mt19937_64 rng(DefaultSeed);
+		auto name = [&] { return Names[rng() % std::size(Names)]; };
+
+		string r;
+		r.reserve(size + 4096);
+		for (uintptr i = 0; r.size() < size; ++i)
+		{
+			r += "`Generated function ";
+			r += std::to_string(i);
+			r += ".\nDo not edit.`\n";
+			r += name();
+			r += std::to_string(i);
+			r += "(int a, int b) => int:\n{\n";
+			for (auto j = rng() % 32; j != 0; --j)
+			{
+				r += "\tint ";
+				r += name();
+				r += " = a ";
+				r += Operators[rng() % std::size(Operators)];
+				r += ' ';
+				r += std::to_string(rng() % 100000);
+				r += (rng() % 4) == 0 ? " ``Trailing comment.\n" : "\n";
+			}
+			r += "\treturn a + b\n}\n\n";
+		}
+		return r;
+	}
+
+	static bool SameTokens(const TokenStream& lhs, const TokenStream& rhs)
+	{
+		return
+			lhs.types == rhs.types &&
+			lhs.offsets == rhs.offsets &&
+			lhs.sizes == rhs.sizes &&
+			lhs.literals.size() == rhs.literals.size();
+	}
+
+	void ParallelLexing()
+	{
+		constexpr uintptr Size = 256 << 20;
+
+		auto text = MakeGeneratedSource(Size);
+		auto max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+		TokenStream sequential;
+		sequential.Lex(text);
+
+		printf("--- Parallel lexing, %.1f MB, %zu tokens ---\n", text.size() / 1e6, (size_t)sequential.Size());
+
+		vector<uint32> thread_counts;
+		for (uint32 i = 1; i < max_threads; i *= 2)
+			thread_counts.push_back(i);
+		thread_counts.push_back(max_threads);
+
+		double baseline = 0;
+		for (auto threads : thread_counts)
+		{
+			TokenStream tokens;
+			auto seconds = MeasureSeconds([&] { tokens.LexParallel(text, threads); }, 3);
+			if (!SameTokens(tokens, sequential))
+			{
+				printf("LexParallel with %u threads does not match Lex.\n", threads);
+				return;
+			}
+			if (threads == 1)
+				baseline = seconds;
+			printf("%3u threads %10.2f MB/s %6.2fx\n", threads, text.size() / seconds * 1e-6, baseline / seconds);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "Bench.hpp"
+#include <zcc_core/Parser.hpp>
+#include <zcc_test/Sources.hpp>
+#include <new>
+#include <thread>
+
+
+
+// Counts every heap allocation of the process, so the bench can tell what a parser allocates per file. The AST itself comes from
+// its own pools, these are the containers around it.
+static std::atomic<Zero::uint64> allocation_count;
+
+void* operator new(size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (auto r = malloc(size != 0 ? size : 1); r != nullptr)
+		return r;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+namespace Zero::Bench
+{
+	// Small files of functions, declarations and namespaces, like the modules of a program.
+	static vector<string> MakeSourceFiles(uint32 count, uint32 items)
+	{
+		using Test::SourceItem;
+		std::mt19937_64 rng(DefaultSeed);
+		vector<string> r(count);
+		for (auto& file : r)
+			file = Test::MakeSource(rng, { SourceItem::Function, SourceItem::Declaration, SourceItem::Namespace, SourceItem::Comment }, items);
+		return r;
+	}
+
+	void ParserReuse()
+	{
+		constexpr uint32 FileCount = 2000;
+
+		auto files = MakeSourceFiles(FileCount, 64);
+		uintptr bytes = 0;
+		for (auto& e : files)
+			bytes += e.size();
+
+		printf("--- Parser reuse, %u files, %.1f MB ---\n", FileCount, bytes / 1e6);
+
+		uint64 allocations = 0;
+		auto count = [&](auto&& fn)
+		{
+			return [&]
+			{
+				auto before = allocation_count.load(std::memory_order_relaxed);
+				fn();
+				allocations = allocation_count.load(std::memory_order_relaxed) - before;
+			};
+		};
+
+		uintptr items = 0;
+		auto fresh = MeasureSeconds(count([&]
+		{
+			for (auto& e : files)
+			{
+				Parser parser(e);
+				parser.ParseEach([&](Expression&&) { ++items; });
+			}
+		}), 3);
+		printf("%-8s %10.2f MB/s %10.1f allocations per file\n", "fresh", bytes / fresh * 1e-6, (double)allocations / FileCount);
+
+		Parser parser;
+		auto reused = MeasureSeconds(count([&]
+		{
+			for (auto& e : files)
+			{
+				parser.Reset(e);
+				parser.ParseEach([&](Expression&&) { ++items; });
+			}
+		}), 3);
+		printf("%-8s %10.2f MB/s %10.1f allocations per file\n", "reused", bytes / reused * 1e-6, (double)allocations / FileCount);
+		DoNotOptimize(items);
+	}
+
+	// ParseFileParallel against ParseFile on one big well-formed file. Every split holds there; a file whose error falls on the last
+	// item of a chunk would pay for the threads and then for ParseFile on top, see ParseFileParallel.
+	void ParallelParsing()
+	{
+		string text;
+		for (auto& e : MakeSourceFiles(256, 1024))
+			text += e;
+		auto max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+		printf("--- Parallel parsing, %.1f MB ---\n", text.size() / 1e6);
+
+		vector<uint32> thread_counts;
+		for (uint32 i = 1; i < max_threads; i *= 2)
+			thread_counts.push_back(i);
+		thread_counts.push_back(max_threads);
+
+		for (auto defer_bodies : { false, true })
+		{
+			uintptr items = 0;
+			auto sequential = MeasureSeconds([&]
+			{
+				Parser parser(text);
+				parser.defer_bodies = defer_bodies;
+				items = parser.ParseFile().global_scope.expressions.size();
+			}, 3);
+			printf("%-8s ParseFile %10.2f MB/s, %zu items\n", defer_bodies ? "deferred" : "parsed", text.size() / sequential * 1e-6, (size_t)items);
+
+			for (auto threads : thread_counts)
+			{
+				uintptr parallel_items = 0;
+				auto seconds = MeasureSeconds([&]
+				{
+					Parser parser(text);
+					parser.defer_bodies = defer_bodies;
+					parallel_items = parser.ParseFileParallel(threads).global_scope.expressions.size();
+				}, 3);
+				if (parallel_items != items)
+				{
+					printf("ParseFileParallel with %u threads does not match ParseFile.\n", threads);
+					return;
+				}
+				printf("%3u threads %10.2f MB/s %6.2fx\n", threads, text.size() / seconds * 1e-6, sequential / seconds);
+			}
+		}
+	}
+
+	void IncrementalReparse()
+	{
+		constexpr uint32 EditCount = 1000;
+
+		string text;
+		for (auto& e : MakeSourceFiles(64, 1024))
+			text += e;
+
+		printf("--- Incremental reparse, %.1f MB, %u digit edits ---\n", text.size() / 1e6, EditCount);
+
+		// Edits that add a digit to a number and take it out again, the most common kind of keystroke that keeps the file well
+		// formed, and one that moves everything after it. With bodies parsed, the items after the edit hold many more nodes. The
+		// same file inside one namespace is a single top-level item, Reparse must go down to its elements to keep up.
+		for (auto wrapped : { false, true })
+		{
+			auto source = wrapped ? "namespace All {\n" + text + "}\n" : text;
+			vector<uint32> digits;
+			for (uint32 i = 0; i != source.size(); ++i)
+				if (isdigit((uint8)source[i]))
+					digits.push_back(i);
+
+			for (auto defer_bodies : { true, false })
+			{
+				std::mt19937_64 rng(DefaultSeed);
+				string buffers[2] = { source, source };
+				Parser parser(buffers[0]);
+				parser.defer_bodies = defer_bodies;
+				auto items = parser.ParseFile().global_scope.expressions.size();
+
+				auto t0 = Clock::now();
+				uint32 offset = 0;
+				for (uint32 i = 0; i != EditCount; ++i)
+				{
+					auto& next = buffers[(i + 1) % 2];
+					next = buffers[i % 2];
+					if (i % 2 == 0)
+					{
+						offset = digits[rng() % digits.size()];
+						next.insert(next.begin() + offset, (char)('1' + rng() % 9));
+						parser.Reparse(next, { offset, 0, 1 });
+					}
+					else
+					{
+						next.erase(offset, 1);
+						parser.Reparse(next, { offset, 1, 0 });
+					}
+				}
+				auto reparse = std::chrono::duration<double>(Clock::now() - t0).count() / EditCount;
+
+				auto full = MeasureSeconds([&]
+				{
+					Parser fresh(buffers[EditCount % 2]);
+					fresh.defer_bodies = defer_bodies;
+					DoNotOptimize(fresh.ParseFile().global_scope.expressions.size());
+				}, 3);
+
+				printf("%-8s %-9s %zu items, ParseFile %10.3f ms, Reparse %10.3f ms per edit, %6.1fx\n", defer_bodies ? "deferred" : "parsed",
+					wrapped ? "namespace" : "", items, full * 1e3, reparse * 1e3, full / reparse);
+			}
+		}
+	}
+}
\ No newline at end of file
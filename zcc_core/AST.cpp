@@ -12,9 +12,10 @@ namespace Zero
             return std::make_pair(false, Type());
         }
 
+        // Statements have no type, and names have none until they are resolved, so neither is known yet.
         Type Untyped::GetType(Parser& parser)
         {
-            abort();
+            return {};
         }
 
         HashT ExpressionHasher::operator()(const Expression& e) const
@@ -64,11 +65,11 @@ namespace Zero
 
         if constexpr (Detail::IsScopedPtr<V>::Value)
         {
-            return value->GetHash();
+            return value != nullptr ? value->GetHash() : 0;
         }
         else if constexpr (std::is_pointer_v<V>)
         {
-            return value->GetHash();
+            return value != nullptr ? value->GetHash() : 0;
         }
         else if constexpr (Detail::IsVector<V>::Value)
         {
@@ -96,14 +97,15 @@ namespace Zero
         return type == other.type && name == other.name && init == other.init;
     }
 
+    // The type is left out where it couldn't be inferred from init yet.
     Type Declaration::GetType(Parser& parser) const
     {
-        return type->GetType(parser);
+        return type != nullptr ? type->GetType(parser) : Type();
     }
 
     bool Declaration::IsConst() const
     {
-        return type->IsConst() && name.IsConst() && init->IsConst();
+        return type != nullptr && type->IsConst() && name.IsConst() && (init == nullptr || init->IsConst());
     }
 
     HashT Declaration::GetHash() const
@@ -146,6 +148,12 @@ namespace Zero
         return ScopedPtr<std::remove_reference_t<decltype(*this)>>::New(std::move(*this));
     }
 
+    // A deep copy of the subtree, offsets included. Parsing never needs one, the nodes it builds are only ever moved.
+    Expression Expression::Clone() const
+    {
+        return Detail::Clone(*this);
+    }
+
     bool Expression::operator==(const Expression& other) const
     {
         if (ID() != other.ID())
@@ -169,11 +177,21 @@ namespace Zero
         return r;
     }
 
+    // Whether two children that may be missing are the same, such as the body of a function that failed to parse.
+    static bool SameChild(const ScopedPtr<Expression>& lhs, const ScopedPtr<Expression>& rhs)
+    {
+        return lhs == nullptr || rhs == nullptr ? lhs == rhs : *lhs == *rhs;
+    }
+
+    // A body skipped by Parser::defer_bodies isn't known until ParseDeferredBody parses it, so a function that still has one only
+    // equals itself. Its return type is missing too, unless it was written out.
     bool Function::operator==(const Function& other) const
     {
+        if (HasDeferredBody() || other.HasDeferredBody())
+            return this == &other;
         if (params != other.params)
             return false;
-        if (*body != *other.body || *return_type != *other.return_type)
+        if (!SameChild(body, other.body) || !SameChild(return_type, other.return_type))
             return false;
         for (size_t i = 0; i < params.size(); i++)
             if (params[i] != other.params[i])
@@ -183,6 +201,8 @@ namespace Zero
 
     bool Function::IsConst() const
     {
+        if (body == nullptr || return_type == nullptr)
+            return false;
         if (!return_type->IsConst() || !body->IsConst())
             return false;
         for (auto& e : params)
@@ -203,7 +223,11 @@ namespace Zero
 
     HashT Function::GetHash() const
     {
-        auto r = body->GetHash() ^ return_type->GetHash();
+        HashT r = 0;
+        if (body != nullptr)
+            r ^= body->GetHash();
+        if (return_type != nullptr)
+            r ^= return_type->GetHash();
         for (auto& e : params)
             r ^= e.GetHash();
         return r;
@@ -227,6 +251,29 @@ namespace Zero
         return true;
     }
 
+    // The return type all candidates agree on. A candidate whose type is not known yet, like that of a name, agrees with any other,
+    // and leaves the result unknown too.
+    static std::pair<bool, Type> CommonReturnType(Parser& parser, vector<Type>& candidates)
+    {
+        if (candidates.size() == 0)
+            return { false, Void() };
+
+        Type* known = nullptr;
+        bool unknown = false;
+        for (auto& e : candidates)
+        {
+            if (e.IsEmpty())
+                unknown = true;
+            else if (known == nullptr)
+                known = &e;
+            else if (e != *known)
+                parser.Error("Ambiguous function return type.");
+        }
+        if (unknown)
+            return std::make_pair(true, Type());
+        return std::make_pair<bool, Type>(true, std::move(*known));
+    }
+
     std::pair<bool, Type> Scope::InferReturnType(Parser& parser) const
     {
         std::vector<Type> candidates;
@@ -238,17 +285,10 @@ namespace Zero
                 v = e.InferReturnType(parser);
 
             if (v.first)
-                candidates.push_back(v.second);
+                candidates.push_back(std::move(v.second));
         }
 
-        if (candidates.size() == 0)
-            return { false, Void() };
-
-        auto& first = candidates.front();
-        for (auto i = candidates.begin() + 1; i != candidates.end(); ++i)
-            if (i->GetType(parser) != first.GetType(parser))
-                parser.Error("Ambiguous function return type.");
-        return std::make_pair<bool, Type>(true, std::move(first));
+        return CommonReturnType(parser, candidates);
     }
 
     HashT Scope::GetHash() const
@@ -277,10 +317,14 @@ namespace Zero
     std::pair<bool, Type> Branch::InferReturnType(Parser& parser) const
     {
         auto tr = on_true->InferReturnType(parser);
-        auto fr = on_false->InferReturnType(parser);
+        auto fr = on_false != nullptr ? on_false->InferReturnType(parser) : std::make_pair(false, Type());
         if (tr.first && fr.first)
-            if (tr.second != fr.second)
-                parser.Error("Ambiguous function return type.");
+        {
+            vector<Type> candidates;
+            candidates.push_back(std::move(tr.second));
+            candidates.push_back(std::move(fr.second));
+            return CommonReturnType(parser, candidates);
+        }
         return tr.first ? std::move(tr) : std::move(fr);
     }
 
@@ -325,7 +369,7 @@ namespace Zero
                 v = e.second.InferReturnType(parser);
 
             if (v.first)
-                candidates.push_back(v.second);
+                candidates.push_back(std::move(v.second));
         }
 
         if (default_case != nullptr)
@@ -336,17 +380,10 @@ namespace Zero
                 v = e.InferReturnType(parser);
 
             if (v.first)
-                candidates.push_back(v.second);
-
-            if (candidates.size() == 0)
-                return { false, Void() };
+                candidates.push_back(std::move(v.second));
         }
 
-        auto& first = candidates.front();
-        for (auto i = candidates.begin() + 1; i != candidates.end(); ++i)
-            if (i->GetType(parser) != first.GetType(parser))
-                parser.Error("Ambiguous function return type.");
-        return std::make_pair<bool, Type>(true, std::move(first));
+        return CommonReturnType(parser, candidates);
     }
 
     HashT Select::GetHash() const
@@ -451,9 +488,10 @@ namespace Zero
         return other->IsConst();
     }
 
+    // Not known before the operand's type and the operator overloads are, which takes name resolution.
     Type UnaryExpression::GetType(Parser& parser) const
     {
-        abort();
+        return {};
     }
 
     HashT UnaryExpression::GetHash() const
@@ -471,9 +509,10 @@ namespace Zero
         return lhs->IsConst() && rhs->IsConst();
     }
 
+    // Not known before the operands' types and the operator overloads are, which takes name resolution.
     Type BinaryExpression::GetType(Parser& parser) const
     {
-        abort();
+        return {};
     }
 
     HashT BinaryExpression::GetHash() const
@@ -498,6 +537,8 @@ namespace Zero
 
     bool Return::operator==(const Return& other) const
     {
+        if (value == nullptr || other.value == nullptr)
+            return value == nullptr && other.value == nullptr;
         return *value == *other.value;
     }
 
@@ -516,7 +557,7 @@ namespace Zero
 
     HashT Return::GetHash() const
     {
-        return WellonsMix(value->GetHash());
+        return value != nullptr ? WellonsMix(value->GetHash()) : 0;
     }
 
     bool Yield::operator==(const Yield& other) const
@@ -575,7 +616,7 @@ namespace Zero
 
     Type Type::GetType(Parser& parser) const
     {
-        return *this;
+        return Clone();
     }
 
     ScopedPtr<Type> Type::ToPtr()
@@ -583,6 +624,11 @@ namespace Zero
         return ScopedPtr<std::remove_reference_t<decltype(*this)>>::New(std::move(*this));
     }
 
+    Type Type::Clone() const
+    {
+        return Detail::Clone(*this);
+    }
+
     template <typename T>
     struct IsScopedPtr
     {
@@ -615,9 +661,10 @@ namespace Zero
         return h;
     }
 
+    // Not known before the name is resolved, which the parser doesn't do.
     Type Identifier::GetType(Parser& parser) const
     {
-        abort();
+        return {};
     }
 
     HashT Identifier::GetHash() const
@@ -674,6 +721,16 @@ namespace Zero
         return WellonsMix((HashT)value);
     }
 
+    Type LiteralBigInt::GetType(Parser& parser) const
+    {
+        return Int((value.BitWidth() + 63) / 64 * 64);
+    }
+
+    HashT LiteralBigInt::GetHash() const
+    {
+        return XXHash(value.words.data(), value.words.size() * sizeof(uint64));
+    }
+
     Type LiteralUint::GetType(Parser& parser) const
     {
         return UInt();
@@ -913,9 +970,10 @@ namespace Zero
         return callable->InferReturnType(parser).second;
     }
 
+    // A call doesn't return from the function it is in.
     std::pair<bool, Type> FunctionCall::InferReturnType(Parser& parser) const
     {
-        abort();
+        return std::make_pair(false, Type());
     }
 
     HashT FunctionCall::GetHash() const
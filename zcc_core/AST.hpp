@@ -8,6 +8,8 @@
 	TYPE() = default; \
 	TYPE(const TYPE&) = default; \
 	TYPE& operator=(const TYPE&) = default; \
+	TYPE(TYPE&&) = default; \
+	TYPE& operator=(TYPE&&) = default; \
 	~TYPE() = default
 
 #define ALWAYS_EQUAL   \
@@ -461,6 +463,7 @@ namespace Zero
 
 		Type GetType(Parser& parser) const;
 		ScopedPtr<Type>			ToPtr();
+		Type					Clone() const;
 		HashT GetHash() const;
 	};
 
@@ -497,6 +500,16 @@ namespace Zero
 
 
 
+	// The tokens an item, a top-level one or a namespace element, was parsed from start at first. Its parse looked at tokens up to
+	// reach, which is at least the token after the item and may lie further ahead.
+	struct ItemExtent
+	{
+		uint32 first;
+		uint32 reach;
+	};
+
+
+
 	struct Namespace:
 		Detail::CategoryWrapper<>,
 		Detail::NoReturnType,
@@ -504,7 +517,10 @@ namespace Zero
 		Detail::Untyped
 	{
 		Identifier name;
-		vector<Expression> elements;
+		vector<Expression> elements;	// Items of their own, which their nodes' offsets and deferred bodies count from.
+		vector<ItemExtent> extents;		// Of each element, from the first token of the item the namespace is in.
+		uint32 last = 0;				// The closing brace, from there too,
+		uint32 reach = 0;				// and what the tokens after the last element looked at.
 
 		TYPE_HEADER(Namespace);
 		ALWAYS_EQUAL
@@ -525,7 +541,7 @@ namespace Zero
 		ScopedPtr<Expression> init;
 
 		inline Declaration(ScopedPtr<Expression> type, Identifier name, ScopedPtr<Expression> init = nullptr) :
-			type(type), name(name), init(init)
+			type(std::move(type)), name(name), init(std::move(init))
 		{
 		}
 
@@ -550,7 +566,7 @@ namespace Zero
 		ScopedPtr<Expression> new_type;
 
 		inline Cast(ScopedPtr<Expression> value, ScopedPtr<Expression> new_type) :
-			value(value), new_type(new_type)
+			value(std::move(value)), new_type(std::move(new_type))
 		{
 		}
 
@@ -626,6 +642,29 @@ namespace Zero
 
 
 
+	struct LiteralBigInt :
+		Detail::CategoryWrapper<ExpressionCategory::Literal>,
+		Detail::NoReturnType,
+		Detail::AlwaysConst
+	{
+		TYPE_HEADER(LiteralBigInt);
+
+		BigInt value; // Always wider than 64 bits.
+
+		LiteralBigInt(BigInt value) :
+			value(std::move(value))
+		{
+		}
+
+		bool operator==(const LiteralBigInt& other) const { return value == other.value; }
+		DEFAULT_INEQUALITY
+
+		Type GetType(Parser& parser) const;
+		HashT GetHash() const;
+	};
+
+
+
 	struct LiteralUint :
 		Detail::CategoryWrapper<ExpressionCategory::Literal>,
 		Detail::NoReturnType,
@@ -681,6 +720,10 @@ namespace Zero
 		ScopedPtr<Expression>	body;
 		ScopedPtr<Expression>	return_type;
 		vector<Expression>		params;
+		uint32					body_first = 0;	// Token range of a body skipped by Parser::defer_bodies from the start of its item,
+		uint32					body_last = 0;	// empty once it is parsed.
+
+		bool HasDeferredBody() const { return body_first != body_last; }
 
 		bool operator==(const Function& other) const;
 		DEFAULT_INEQUALITY
@@ -702,7 +745,7 @@ namespace Zero
 
 		template <typename F>
 		FunctionCall(F&& callable, vector<Expression> params) :
-			callable(Expression(std::forward<F>(callable)).ToPtr()), params(params)
+			callable(Expression(std::forward<F>(callable)).ToPtr()), params(std::move(params))
 		{
 		}
 
@@ -866,7 +909,7 @@ namespace Zero
 		Operator op;
 
 		inline UnaryExpression(ScopedPtr<Expression> other, Operator op) :
-			other(other), op(op)
+			other(std::move(other)), op(op)
 		{
 		}
 
@@ -891,7 +934,7 @@ namespace Zero
 		Operator op;
 
 		inline BinaryExpression(ScopedPtr<Expression> lhs, ScopedPtr<Expression> rhs, Operator op) :
-			lhs(lhs), rhs(rhs), op(op)
+			lhs(std::move(lhs)), rhs(std::move(rhs)), op(op)
 		{
 		}
 
@@ -945,7 +988,7 @@ namespace Zero
 		ScopedPtr<Expression> body;
 
 		inline Defer(ScopedPtr<Expression> body) :
-			body(body)
+			body(std::move(body))
 		{
 		}
 
@@ -967,7 +1010,7 @@ namespace Zero
 		ScopedPtr<Expression> value;
 
 		inline Return(ScopedPtr<Expression> value) :
-			value(value)
+			value(std::move(value))
 		{
 		}
 
@@ -990,7 +1033,7 @@ namespace Zero
 		ScopedPtr<Expression> value;
 
 		inline Yield(ScopedPtr<Expression> value) :
-			value(value)
+			value(std::move(value))
 		{
 		}
 
@@ -1030,7 +1073,7 @@ namespace Zero
 		ScopedPtr<Expression> value;
 
 		inline TraitsOf(ScopedPtr<Expression> value) :
-			value(value)
+			value(std::move(value))
 		{
 		}
 
@@ -1100,7 +1143,7 @@ namespace Zero
 			UnaryExpression,
 			BinaryExpression,
 			Declaration,
-			LiteralNil, LiteralBool, LiteralInt, LiteralUint, LiteralReal,
+			LiteralNil, LiteralBool, LiteralInt, LiteralBigInt, LiteralUint, LiteralReal,
 			Break, Continue, Defer, Return, Yield,
 			Wildcard,
 			TraitsOf,
@@ -1117,6 +1160,8 @@ namespace Zero
 
 		TYPE_HEADER(Expression);
 
+		uint32 offset = 0; // Byte offset of the first token from the start of its item, see Parser::item_offset.
+
 		template <typename T, typename = std::enable_if_t<!std::is_same_v<std::remove_reference_t<T>, Expression>>>
 		Expression(T&& value) :
 			Base()
@@ -1129,6 +1174,7 @@ namespace Zero
 		std::pair<bool, Type>	InferReturnType(Parser& parser) const;
 		HashT GetHash() const;
 		ScopedPtr<Expression>	ToPtr();
+		Expression				Clone() const;
 
 		bool operator==(const Expression& other) const;
 		DEFAULT_INEQUALITY
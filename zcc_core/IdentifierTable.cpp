@@ -0,0 +1,73 @@
+#include "IdentifierTable.hpp"
+
+
+
+namespace Zero
+{
+	static constexpr uint32 EMPTY_SLOT = UINT32_MAX;
+
+	IdentifierID IdentifierTable::Intern(string_view name, uint64 hash)
+	{
+		assert(hash == IdentifierHash(name));
+
+		if ((names.size() + 1) * 2 > slots.size())
+			Grow();
+
+		auto mask = slots.size() - 1;
+		for (auto i = (uintptr)hash & mask;; i = (i + 1) & mask)
+		{
+			auto& slot = slots[i];
+			if (slot.index == EMPTY_SLOT)
+			{
+				slot = { hash, (uint32)names.size() };
+				names.push_back(name);
+				hashes.push_back(hash);
+				return (IdentifierID)slot.index;
+			}
+			if (slot.hash == hash && names[slot.index] == name)
+				return (IdentifierID)slot.index;
+		}
+	}
+
+	// Like Intern, but a name seen for the first time is copied into storage, so name may be a temporary.
+	IdentifierID IdentifierTable::InternCopy(string_view name, uint64 hash)
+	{
+		auto count = names.size();
+		auto r = Intern(name, hash);
+		if (names.size() != count)
+			names.back() = storage.Store(name);
+		return r;
+	}
+
+	// Interns a name from another table, taking a copy if it lives in that table's storage rather than in the source.
+	IdentifierID IdentifierTable::Import(const IdentifierTable& other, IdentifierID id)
+	{
+		auto name = other.Name(id);
+		if (other.storage.Owns(name.data()))
+			return InternCopy(name, other.Hash(id));
+		return Intern(name, other.Hash(id));
+	}
+
+	// Keeps the slots at their size, so refilling the table with about as many names doesn't grow it again.
+	void IdentifierTable::Clear()
+	{
+		std::fill(slots.begin(), slots.end(), Slot{ 0, EMPTY_SLOT });
+		names.clear();
+		hashes.clear();
+		storage.Clear();
+	}
+
+	void IdentifierTable::Grow()
+	{
+		auto size = std::max<uintptr>(slots.size() * 2, 256);
+		slots.assign(size, Slot{ 0, EMPTY_SLOT });
+		auto mask = size - 1;
+		for (uint32 j = 0; j != names.size(); ++j)
+		{
+			auto i = (uintptr)hashes[j] & mask;
+			while (slots[i].index != EMPTY_SLOT)
+				i = (i + 1) & mask;
+			slots[i] = { hashes[j], j };
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "Util.hpp"
+
+
+
+namespace Zero
+{
+	// Identifier hash, one cheap step per char so the tokenizer can compute it while it scans the name, mixed once at the end.
+	constexpr uint64 IDENTIFIER_HASH_SEED = 5381;
+
+	constexpr uint64 IdentifierHashStep(uint64 h, char c)
+	{
+		return (h * 33) ^ (uint8)c;
+	}
+
+	constexpr uint64 IdentifierHashFinish(uint64 h)
+	{
+		return WellonsMix(h);
+	}
+
+	constexpr uint64 IdentifierHash(string_view name)
+	{
+		auto h = IDENTIFIER_HASH_SEED;
+		for (auto c : name)
+			h = IdentifierHashStep(h, c);
+		return IdentifierHashFinish(h);
+	}
+
+
+
+	// Interns identifier names into dense IDs, in order of first appearance. Lookups take the IdentifierHash from the caller, so a name
+	// the tokenizer just scanned is never walked again except for the final comparison. Names are views into the source text, except
+	// for the NFC forms of Unicode names that differ from their spelling, which the table keeps in storage.
+	struct IdentifierTable
+	{
+		struct Slot
+		{
+			uint64 hash;
+			uint32 index; // Into names, UINT32_MAX if the slot is empty.
+		};
+
+		vector<Slot>		slots; // Open addressing with linear probing, the size is a power of two.
+		vector<string_view>	names;
+		vector<uint64>		hashes;
+		StringArena			storage;
+
+		IdentifierTable() = default;
+		IdentifierTable(const IdentifierTable&) = default;
+		IdentifierTable& operator=(const IdentifierTable&) = default;
+		~IdentifierTable() = default;
+
+		IdentifierID	Intern(string_view name, uint64 hash);
+		IdentifierID	Intern(string_view name) { return Intern(name, IdentifierHash(name)); }
+		IdentifierID	InternCopy(string_view name, uint64 hash);
+		IdentifierID	Import(const IdentifierTable& other, IdentifierID id);
+		void			Clear();
+
+		uintptr			Size() const { return names.size(); }
+		string_view		Name(IdentifierID id) const { return names[(uintptr)id]; }
+		uint64			Hash(IdentifierID id) const { return hashes[(uintptr)id]; }
+
+		void			Grow();
+	};
+}
\ No newline at end of file
@@ -2,13 +2,7 @@
 
 namespace Zero
 {
-	static const auto symbol_lookup = []
-	{
-		HashMap<string_view, Keyword> r = {};
-		for (uint8 i = 0; i != (uint8)Keyword::MaxEnum; ++i)
-			r.insert({ KEYWORD_STRINGS[i], (Keyword)i });
-		return r;
-	}();
+	static_assert(std::size(KEYWORD_STRINGS) == (uintptr)Keyword::MaxEnum);
 
 	static constexpr auto MAX_KEYWORD_SIZE = []()
 	{
@@ -28,13 +22,132 @@ namespace Zero
 		return r;
 	}();
 
-    Keyword IsKeyword(string_view token)
+	static_assert(MIN_KEYWORD_SIZE >= 2 && MAX_KEYWORD_SIZE <= 16, "A keyword is compared as two words of at least two chars.");
+
+
+
+	// A token of 2 to 16 chars, as two (possibly overlapping) little-endian words.
+	struct KeywordWords
+	{
+		uint64 head;
+		uint64 tail;
+	};
+
+	static constexpr uintptr KeywordWordSize(uintptr size)
+	{
+		return size >= 8 ? 8 : size >= 4 ? 4 : 2;
+	}
+
+	static constexpr KeywordWords MakeKeywordWords(string_view text)
+	{
+		auto width = KeywordWordSize(text.size());
+		auto load = [&](uintptr offset)
+		{
+			uint64 r = 0;
+			for (uintptr i = 0; i != width; ++i)
+				r |= (uint64)(uint8)text[offset + i] << (i * 8);
+			return r;
+		};
+		return { load(0), load(text.size() - width) };
+	}
+
+	static KeywordWords LoadKeywordWords(const char* data, uintptr size)
+	{
+		KeywordWords r = {};
+		switch (KeywordWordSize(size))
+		{
+		case 8:
+			(void)memcpy(&r.head, data, 8);
+			(void)memcpy(&r.tail, data + size - 8, 8);
+			break;
+		case 4:
+		{
+			uint32 head, tail;
+			(void)memcpy(&head, data, 4);
+			(void)memcpy(&tail, data + size - 4, 4);
+			r = { head, tail };
+			break;
+		}
+		default:
+		{
+			uint16 head, tail;
+			(void)memcpy(&head, data, 2);
+			(void)memcpy(&tail, data + size - 2, 2);
+			r = { head, tail };
+			break;
+		}
+		}
+		return r;
+	}
+
+
+
+	static constexpr uint32 KEYWORD_TABLE_BITS = 7;
+	static constexpr uint32 KEYWORD_TABLE_SIZE = 1U << KEYWORD_TABLE_BITS;
+
+	// Slot of a keyword given its IdentifierHash, which the tokenizer already computed while scanning it.
+	static constexpr uint32 KeywordHash(uint64 hash, uint64 seed)
+	{
+		return (uint32)((hash * seed) >> (64 - KEYWORD_TABLE_BITS));
+	}
+
+	struct KeywordTable
+	{
+		uint64			seed;
+		uint8			slots[KEYWORD_TABLE_SIZE];
+		uint8			sizes[(uintptr)Keyword::MaxEnum];
+		KeywordWords	words[(uintptr)Keyword::MaxEnum];
+	};
+
+	// Searches for a multiplier that maps every keyword to its own slot.
+	static constexpr auto keyword_table = []
+	{
+		KeywordTable r = {};
+		for (uint32 i = 0; i != 256; ++i)
+		{
+			r.seed = WellonsMix((uint64)i) | 1;
+			for (auto& e : r.slots)
+				e = (uint8)Keyword::MaxEnum;
+			bool collision = false;
+			for (uint8 j = 0; j != (uint8)Keyword::MaxEnum && !collision; ++j)
+			{
+				auto& slot = r.slots[KeywordHash(IdentifierHash(KEYWORD_STRINGS[j]), r.seed)];
+				collision = slot != (uint8)Keyword::MaxEnum;
+				slot = j;
+			}
+			if (!collision)
+				break;
+			r.seed = 0;
+		}
+		for (uint8 j = 0; j != (uint8)Keyword::MaxEnum; ++j)
+		{
+			r.sizes[j] = (uint8)KEYWORD_STRINGS[j].size();
+			r.words[j] = MakeKeywordWords(KEYWORD_STRINGS[j]);
+		}
+		return r;
+	}();
+
+	static constexpr uint64 KEYWORD_HASH_SEED = keyword_table.seed;
+	static_assert(KEYWORD_HASH_SEED != 0, "No perfect hash found for KEYWORD_STRINGS, try a bigger table.");
+
+
+
+    Keyword IsKeyword(string_view token, uint64 hash)
     {
 		if (token.size() < MIN_KEYWORD_SIZE || token.size() > MAX_KEYWORD_SIZE)
 			return Keyword::MaxEnum;
-		auto it = symbol_lookup.find(token);
-		if (it != symbol_lookup.end())
-			return it->second;
-		return Keyword::MaxEnum;
+		auto i = keyword_table.slots[KeywordHash(hash, KEYWORD_HASH_SEED)];
+		if (i == (uint8)Keyword::MaxEnum || keyword_table.sizes[i] != token.size())
+			return Keyword::MaxEnum;
+		auto lhs = LoadKeywordWords(token.data(), token.size());
+		auto& rhs = keyword_table.words[i];
+		if (((lhs.head ^ rhs.head) | (lhs.tail ^ rhs.tail)) != 0)
+			return Keyword::MaxEnum;
+		return (Keyword)i;
+    }
+
+    Keyword IsKeyword(string_view token)
+    {
+		return IsKeyword(token, IdentifierHash(token));
     }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "Util.hpp"
+#include "IdentifierTable.hpp"
 
 
 
@@ -40,4 +41,5 @@ namespace Zero
 	};
 
 	Keyword IsKeyword(string_view token);
+	Keyword IsKeyword(string_view token, uint64 hash); // hash must be IdentifierHash(token).
 }
\ No newline at end of file
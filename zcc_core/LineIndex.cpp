@@ -0,0 +1,38 @@
+#include "LineIndex.hpp"
+#include "SIMD.hpp"
+
+
+
+namespace Zero
+{
+	void LineIndex::Build(string_view text)
+	{
+		assert(text.size() <= UINT32_MAX);
+
+		line_starts.clear();
+		line_starts.push_back(0);
+
+		auto begin = text.data();
+		auto cursor = begin;
+		auto end = begin + text.size();
+#ifdef ZERO_SIMD
+		using SIMD::ByteBlock;
+		for (; (uintptr)(end - cursor) >= ByteBlock::Size; cursor += ByteBlock::Size)
+		{
+			auto offset = (uint32)(cursor - begin) + 1;
+			for (auto mask = ByteBlock::Load(cursor).Equal('\n'); mask != 0; mask &= mask - 1)
+				line_starts.push_back(offset + CountTrailingZeros(mask));
+		}
+#endif
+		for (; cursor != end; ++cursor)
+			if (*cursor == '\n')
+				line_starts.push_back((uint32)(cursor - begin) + 1);
+	}
+
+	SourceLocation LineIndex::Locate(uint32 offset) const
+	{
+		assert(IsBuilt());
+		auto i = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin() - 1;
+		return { (uint32)i + 1, offset - line_starts[i] + 1 };
+	}
+}
\ No newline at end of file
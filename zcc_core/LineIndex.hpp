@@ -0,0 +1,31 @@
+#pragma once
+#include "Util.hpp"
+
+
+
+namespace Zero
+{
+	// 1-based line and byte column of a source offset.
+	struct SourceLocation
+	{
+		uint32 line;
+		uint32 column;
+	};
+
+	// Offset of the first byte of every line. Tokens and expressions only keep a byte offset; this table turns one into a line and column
+	// when a diagnostic actually needs it, so the lexer never counts lines.
+	struct LineIndex
+	{
+		vector<uint32> line_starts;
+
+		LineIndex() = default;
+		LineIndex(const LineIndex&) = default;
+		LineIndex& operator=(const LineIndex&) = default;
+		~LineIndex() = default;
+
+		void			Build(string_view text);
+		void			Clear() { line_starts.clear(); }
+		bool			IsBuilt() const { return !line_starts.empty(); }
+		SourceLocation	Locate(uint32 offset) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "ModuleGraph.hpp"
+#include <thread>
+#include <chrono>
+
+
+
+namespace Zero
+{
+	using Clock = std::chrono::steady_clock;
+
+	// The names of a module path joined by dots, from its identifier tokens, so that no whitespace or comment between them ends up
+	// in the name. path is the text of the path in tokens.source.
+	static string ModuleName(const TokenStream& tokens, string_view path)
+	{
+		auto first = (uint32)(path.data() - tokens.source.data());
+		auto last = first + (uint32)path.size();
+		string r;
+		r.reserve(path.size());
+		auto i = (uintptr)(std::lower_bound(tokens.offsets.begin(), tokens.offsets.end(), first) - tokens.offsets.begin());
+		for (; i < tokens.Size() && tokens.offsets[i] < last; ++i)
+		{
+			if (tokens.types[i] != TokenType::Identifier)
+				continue;
+			if (!r.empty())
+				r += '.';
+			r += tokens.Text(i);
+		}
+		return r;
+	}
+
+	namespace Detail
+	{
+		// One per worker. The owner pushes and takes at the back, so it goes depth first into the modules it just found, while idle
+		// workers steal the oldest ones from the front.
+		struct WorkQueue
+		{
+			std::mutex lock;
+			std::deque<ModuleGraph::Node*> nodes;
+
+			void Push(ModuleGraph::Node* node)
+			{
+				std::lock_guard guard(lock);
+				nodes.push_back(node);
+			}
+
+			ModuleGraph::Node* Take(bool owner)
+			{
+				std::lock_guard guard(lock);
+				if (nodes.empty())
+					return nullptr;
+				ModuleGraph::Node* r;
+				if (owner)
+				{
+					r = nodes.back();
+					nodes.pop_back();
+				}
+				else
+				{
+					r = nodes.front();
+					nodes.pop_front();
+				}
+				return r;
+			}
+		};
+
+		struct ModuleGraphRun
+		{
+			ModuleGraph& graph;
+			vector<string> directories;
+			vector<WorkQueue> queues;
+			std::atomic<uintptr> pending;	// Modules queued or being parsed, the workers stop when it drops to zero.
+
+			ModuleGraphRun(ModuleGraph& graph, vector<string> directories, uint32 thread_count) :
+				graph(graph), directories(std::move(directories)), queues(thread_count), pending(0)
+			{
+			}
+
+			bool Resolve(ModuleGraph::Node& node)
+			{
+				auto relative = node.name;
+				std::replace(relative.begin(), relative.end(), '.', '/');
+				relative += graph.extension;
+				for (auto& e : directories)
+				{
+					auto path = e.empty() ? relative : e + '/' + relative;
+					if (node.file.Open(path.c_str()))
+					{
+						node.path = std::move(path);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void Discover(ModuleGraph::Node& importer, string name, WorkQueue& queue)
+			{
+				ModuleGraph::Node* node = nullptr;
+				uint32 id;
+				{
+					std::lock_guard guard(graph.lock);
+					if (auto it = graph.ids.find(name); it != graph.ids.end())
+					{
+						id = it->second;
+					}
+					else
+					{
+						id = (uint32)graph.nodes.size();
+						node = &graph.nodes.emplace_back();
+						node->id = id;
+						node->name = name;
+						graph.ids.insert({ std::move(name), id });
+					}
+				}
+
+				if (std::find(importer.imports.begin(), importer.imports.end(), id) == importer.imports.end())
+					importer.imports.push_back(id);
+
+				if (node != nullptr)
+				{
+					pending.fetch_add(1, std::memory_order_relaxed);
+					queue.Push(node);
+				}
+			}
+
+			void ParseNode(ModuleGraph::Node& node, WorkQueue& queue)
+			{
+				if (node.id != 0 ? !Resolve(node) : !node.file.Open(node.path.c_str()))
+				{
+					node.path.clear();
+					return;
+				}
+
+				auto t0 = Clock::now();
+				auto& parser = node.parser.emplace(node.file);
+				parser.on_use = [&](string_view path)
+				{
+					Discover(node, ModuleName(parser.tokens, path), queue);
+				};
+				parser.ParseFile();
+				parser.on_use = {}; // The parser outlives this run, so a later Reparse must not call back into it.
+				node.parse_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+			}
+
+			void Work(uint32 self)
+			{
+				auto count = (uint32)queues.size();
+				while (pending.load(std::memory_order_acquire) != 0)
+				{
+					ModuleGraph::Node* node = nullptr;
+					for (uint32 i = 0; i != count && node == nullptr; ++i)
+						node = queues[(self + i) % count].Take(i == 0);
+					if (node == nullptr)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+					ParseNode(*node, queues[self]);
+					pending.fetch_sub(1, std::memory_order_release);
+				}
+			}
+		};
+	}
+
+	ModuleGraph::ModuleGraph() :
+		search_paths(), extension(".zero"), nodes(), ids(), lock(), wall_seconds()
+	{
+	}
+
+	// Returns whether every module that was used could be found and parsed without errors.
+	bool ModuleGraph::Parse(const char* root_path, uint32 thread_count)
+	{
+		using Detail::ModuleGraphRun;
+
+		if (thread_count == 0)
+			thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+		nodes.clear();
+		ids.clear();
+
+		string_view root = root_path;
+		auto slash = root.find_last_of("/\\");
+		vector<string> directories;
+		directories.reserve(search_paths.size() + 1);
+		directories.emplace_back(slash != string_view::npos ? root.substr(0, slash) : string_view());
+		directories.insert(directories.end(), search_paths.begin(), search_paths.end());
+
+		auto t0 = Clock::now();
+		ModuleGraphRun run(*this, std::move(directories), thread_count);
+		auto& node = nodes.emplace_back();
+		node.id = 0;
+		node.path = root;
+		run.pending.store(1, std::memory_order_relaxed);
+		run.queues[0].Push(&node);
+
+		vector<std::thread> threads;
+		threads.reserve(thread_count - 1);
+		for (uint32 i = 1; i != thread_count; ++i)
+			threads.emplace_back([&run, i] { run.Work(i); });
+		run.Work(0);
+		for (auto& e : threads)
+			e.join();
+		wall_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+		return std::all_of(nodes.begin(), nodes.end(), [](const Node& e) { return !e.path.empty() && e.parser->diagnostics.empty(); });
+	}
+
+	// Nodes along the slowest chain of imports from the root, where a chain costs the parse times of its modules added up. Even with
+	// unlimited threads the modules on it are parsed one after the other, so its cost bounds the wall time from below. An import
+	// that closes a cycle adds nothing.
+	vector<uint32> ModuleGraph::CriticalPath()
+	{
+		vector<uint8> state(nodes.size());	// Unvisited, on the stack, done.
+		vector<uint32> next(nodes.size(), UINT32_MAX);
+
+		auto visit = [&](auto& visit, uint32 id) -> void
+		{
+			auto& node = nodes[id];
+			state[id] = 1;
+			double slowest = 0;
+			for (auto e : node.imports)
+			{
+				if (state[e] == 0)
+					visit(visit, e);
+				if (state[e] == 2 && nodes[e].chain_seconds > slowest)
+				{
+					slowest = nodes[e].chain_seconds;
+					next[id] = e;
+				}
+			}
+			node.chain_seconds = node.parse_seconds + slowest;
+			state[id] = 2;
+		};
+
+		vector<uint32> r;
+		if (nodes.empty())
+			return r;
+		visit(visit, 0);
+		for (uint32 id = 0; id != UINT32_MAX; id = next[id])
+			r.push_back(id);
+		return r;
+	}
+
+	void ModuleGraph::Report(FILE* out)
+	{
+		auto path = CriticalPath();
+		double total = 0;
+		for (auto& e : nodes)
+			total += e.parse_seconds;
+
+		fprintf(out, "%zu modules parsed in %.3f ms, %.3f ms of parsing in total\n", nodes.size(), wall_seconds * 1e3, total * 1e3);
+		if (!path.empty())
+			fprintf(out, "Critical path, %.3f ms:\n", nodes[0].chain_seconds * 1e3);
+		for (auto id : path)
+		{
+			auto& node = nodes[id];
+			fprintf(out, "  %10.3f ms  %s\n", node.parse_seconds * 1e3, node.id != 0 ? node.name.c_str() : node.path.c_str());
+		}
+		for (auto& e : nodes)
+		{
+			if (e.path.empty())
+				fprintf(out, "Unresolved module: %s\n", e.id != 0 ? e.name.c_str() : "(root)");
+			else
+				e.parser->ReportDiagnostics(out, e.path);
+		}
+	}
+}
\ No newline at end of file
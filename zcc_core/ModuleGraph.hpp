@@ -0,0 +1,46 @@
+#pragma once
+#include "Util.hpp"
+#include "Parser.hpp"
+#include "SourceFile.hpp"
+#include <deque>
+#include <mutex>
+#include <cstdio>
+
+
+
+namespace Zero
+{
+	// Parses a program from its root file on down, following every use to the file it names. A module is queued on a work-stealing
+	// pool the moment the use that names it is parsed, so its parse overlaps with the rest of its importer's, and every module is
+	// parsed once however many modules use it. Module a.b resolves to a/b plus extension under the first search path that has it.
+	struct ModuleGraph
+	{
+		struct Node
+		{
+			uint32				id;
+			string				name;			// Dotted path as used, empty for the root.
+			string				path;			// File the module resolved to, empty if there was none.
+			SourceFile			file;
+			optional<Parser>	parser;			// Holds the module in this_module, with the tokens it refers to, for Reparse to bring up to date.
+			vector<uint32>		imports;		// Nodes this one uses, in the order its uses were parsed.
+			double				parse_seconds;
+			double				chain_seconds;	// parse_seconds plus the slowest chain of imports below, set by CriticalPath.
+		};
+
+		vector<string>			search_paths;	// The root file's directory is searched first.
+		string					extension;
+		std::deque<Node>		nodes;			// By id, the root is node 0. Stable, so workers keep pointers while others are added.
+		HashMap<string, uint32>	ids;			// By name.
+		std::mutex				lock;			// Guards nodes and ids while parsing.
+		double					wall_seconds;
+
+		ModuleGraph();
+		ModuleGraph(const ModuleGraph&) = delete;
+		ModuleGraph& operator=(const ModuleGraph&) = delete;
+		~ModuleGraph() = default;
+
+		bool			Parse(const char* root_path, uint32 thread_count = 0);
+		vector<uint32>	CriticalPath();
+		void			Report(FILE* out);
+	};
+}
\ No newline at end of file
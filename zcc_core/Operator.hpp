@@ -1,5 +1,6 @@
 #pragma once
 #include "Util.hpp"
+#include <array>
 
 
 
@@ -31,4 +32,45 @@ namespace Zero
 		TraitsAccess,
 		MaxEnum
 	};
+
+
+
+	struct OperatorPrecedence
+	{
+		uint8	binary;			// Binding strength as a binary operator, higher binds tighter, 0 if it is never binary.
+		bool	right_assoc;
+		bool	prefix;			// Can also be a prefix unary operator.
+	};
+
+	// Prefix operators bind tighter than every binary operator except member access: -a.b * c is (-(a.b)) * c.
+	constexpr uint8 PREFIX_PRECEDENCE = 13;
+
+	constexpr auto OPERATOR_PRECEDENCE = []
+	{
+		std::array<OperatorPrecedence, (uint8)Operator::MaxEnum> r = {};
+		auto set = [&](std::initializer_list<Operator> ops, uint8 binary, bool right_assoc = false)
+		{
+			for (auto op : ops)
+				r[(uint8)op] = { binary, right_assoc, false };
+		};
+		set({ Operator::Assign,
+			Operator::AddAssign, Operator::SubAssign, Operator::MulAssign, Operator::DivAssign, Operator::ModAssign,
+			Operator::AndAssign, Operator::OrAssign, Operator::XorAssign,
+			Operator::ShiftLeftAssign, Operator::ShiftRightAssign, Operator::RotateLeftAssign, Operator::RotateRightAssign }, 1, true);
+		set({ Operator::BoolOr }, 2);
+		set({ Operator::BoolAnd }, 3);
+		set({ Operator::Or }, 4);
+		set({ Operator::Xor }, 5);
+		set({ Operator::And }, 6);
+		set({ Operator::CompareEQ, Operator::CompareNE }, 7);
+		set({ Operator::CompareLT, Operator::CompareLE, Operator::CompareGT, Operator::CompareGE }, 8);
+		set({ Operator::CompareTW }, 9);
+		set({ Operator::ShiftLeft, Operator::ShiftRight, Operator::RotateLeft, Operator::RotateRight }, 10);
+		set({ Operator::Add, Operator::Sub }, 11);
+		set({ Operator::Mul, Operator::Div, Operator::Mod }, 12);
+		set({ Operator::MemberAccess, Operator::TraitsAccess }, 14);
+		for (auto op : { Operator::Add, Operator::Sub, Operator::Complement, Operator::Increment, Operator::Decrement, Operator::BoolNot })
+			r[(uint8)op].prefix = true;
+		return r;
+	}();
 }
\ No newline at end of file
@@ -1,37 +1,161 @@
 #include "Parser.hpp"
+#include "UTF8.hpp"
+#include <thread>
+
+#ifdef ZERO_PARSER_PROFILE
+#ifndef _MSC_VER
+#include <x86intrin.h>
+#endif
+#endif
 
 namespace Zero
 {
-    Parser::Parser(string_view text) :
-        tokenizer(text),
-        identifiers(),
+#ifdef ZERO_PARSER_PROFILE
+    namespace Detail
+    {
+        // Measures one call to a production, from where it is declared to the end of the function, however that is left.
+        struct ProductionTimer
+        {
+            Parser& parser;
+            Parser::ProductionProfile& profile;
+            uintptr token;
+            uint64 cycles;
+            uint64 nodes;
+
+            ProductionTimer(Parser& parser, Parser::Production production) :
+                parser(parser),
+                profile(parser.profile[(uintptr)production]),
+                token(parser.Tell()),
+                cycles(__rdtsc()),
+                nodes(scoped_ptr_allocations)
+            {
+                ++profile.calls;
+                ++profile.depth;
+            }
+
+            ~ProductionTimer()
+            {
+                if (--profile.depth != 0)
+                    return;
+                profile.cycles += __rdtsc() - cycles;
+                profile.tokens += std::max(parser.Tell(), token) - token;
+                profile.nodes += scoped_ptr_allocations - nodes;
+            }
+        };
+    }
+
+#define PROFILE_PRODUCTION(NAME) Detail::ProductionTimer production_timer(*this, Production::NAME)
+#else
+#define PROFILE_PRODUCTION(NAME)
+#endif
+
+    Parser::Parser(string_view text, bool padded) :
+        tokens(text, padded),
+        this_module(),
+        ptr_size(sizeof(uintptr) * 8),
+        this_token{ TokenType::MaxEnum, {} },
+        scopes(),
+        this_scope(nullptr),
+        operand_stack(),
+        operator_stack(),
+        defer_bodies(false),
+        token_base(0),
+        on_use(),
+        diagnostics(),
+        max_diagnostics(DefaultMaxDiagnostics),
+        item_extents(),
+        use_paths(),
+        scanned(0),
+        item_first(0),
+        item_offset(0),
+        deep_copies(0)
+#ifdef ZERO_PARSER_PROFILE
+        , profile(),
+        profile_out(stderr),
+        profile_json(false)
+#endif
+    {
+        if (auto bad = ValidateUTF8(text); bad != text.size())
+            diagnostics.push_back({ (uint32)bad, 1, "Malformed UTF-8." });
+        Accept();
+    }
+
+    // Parses tokens that were already lexed and validated, such as a slice of a file starting at token_base.
+    Parser::Parser(TokenStream&& tokens, uintptr token_base) :
+        tokens(std::move(tokens)),
         this_module(),
         ptr_size(sizeof(uintptr) * 8),
         this_token{ TokenType::MaxEnum, {} },
         scopes(),
-        this_scope(nullptr)
+        this_scope(nullptr),
+        operand_stack(),
+        operator_stack(),
+        defer_bodies(false),
+        token_base(token_base),
+        on_use(),
+        diagnostics(),
+        max_diagnostics(DefaultMaxDiagnostics),
+        item_extents(),
+        use_paths(),
+        scanned(0),
+        item_first(0),
+        item_offset(0),
+        deep_copies(0)
+#ifdef ZERO_PARSER_PROFILE
+        , profile(),
+        profile_out(stderr),
+        profile_json(false)
+#endif
     {
+        Accept();
     }
 
     IdentifierID Parser::GetIdentifierID(string_view name)
     {
-        auto count = identifiers.size();
-        auto& e = identifiers[name];
-        if (identifiers.size() != count)
-            e = (IdentifierID)count;
-        return e;
+        return tokens.identifiers.Intern(name);
     }
 
     void Parser::Reset()
     {
-        Destruct(identifiers);
-        tokenizer.cursor = tokenizer.begin;
-        this_token.type = TokenType::MaxEnum;
+        Seek(0);
+    }
+
+    // Starts over on another source as if the parser had been constructed for it, but keeps the capacity of the token stream,
+    // identifier table, stacks and global scope, so parsing a batch of files with one parser stops allocating outside the AST once
+    // it has seen the biggest. Names and literals of the modules parsed before are owned by the parser and don't outlive this.
+    void Parser::Reset(string_view text, bool padded)
+    {
+        tokens.Lex(text, padded);
+        this_module.dependencies.clear();
+        this_module.global_scope.expressions.clear();
+        this_module.global_scope.deferred.clear();
+        this_module.global_scope.declarations.clear();
+        this_token = { TokenType::MaxEnum, {} };
+        scopes.clear();
+        this_scope = nullptr;
+        operand_stack.clear();
+        operator_stack.clear();
+        token_base = 0;
+        diagnostics.clear();
+        item_extents.clear();
+        use_paths.clear();
+        scanned = 0;
+        item_first = 0;
+        item_offset = 0;
+        deep_copies = 0;
+#ifdef ZERO_PARSER_PROFILE
+        profile = {};
+#endif
+        if (auto bad = ValidateUTF8(text); bad != text.size())
+            diagnostics.push_back({ (uint32)bad, 1, "Malformed UTF-8." });
+        Accept();
     }
 
     void Parser::Accept()
     {
-        this_token.type = tokenizer.NextToken(this_token.data);
+        this_token.type = tokens.Peek();
+        this_token.data = tokens.PeekData();
+        tokens.Advance();
     }
 
     bool Parser::Accept(TokenType type)
@@ -42,6 +166,39 @@ namespace Zero
         return r;
     }
 
+    TokenType Parser::Peek(uintptr k) const
+    {
+        assert(k != 0);
+        return tokens.Peek(k - 1); // The stream is already one token past this_token.
+    }
+
+    uintptr Parser::Tell() const
+    {
+        return tokens.Tell() - 1;
+    }
+
+    void Parser::Seek(uintptr index)
+    {
+        tokens.Seek(index);
+        Accept();
+    }
+
+    uint32 Parser::Offset() const
+    {
+        return tokens.Offset(Tell());
+    }
+
+    // Offset() for an AST node, from the start of the item being parsed.
+    uint32 Parser::NodeOffset() const
+    {
+        return Offset() - item_offset;
+    }
+
+    SourceLocation Parser::Locate(uint32 offset) const
+    {
+        return tokens.Locate(offset);
+    }
+
     void Parser::Expect(TokenType type, string_view message)
     {
         Assert(this_token.type == type, message);
@@ -49,8 +206,19 @@ namespace Zero
 
     void Parser::Error(string_view message)
     {
-        fwrite(message.data(), 1, message.size(), stdout);
-        abort();
+        auto i = Tell();
+        Error(tokens.Offset(i), i < tokens.Size() ? tokens.sizes[i] : 0, message);
+    }
+
+    // Records the diagnostic and unwinds to the closest recovery point. Once max_diagnostics are recorded the rest of the input is
+    // skipped, so every enclosing production winds down at the end of the file.
+    void Parser::Error(uint32 offset, uint32 size, string_view message)
+    {
+        if (diagnostics.size() < max_diagnostics)
+            diagnostics.push_back({ offset, size, string(message) });
+        if (diagnostics.size() >= max_diagnostics)
+            Seek(tokens.Size());
+        throw SyntaxError();
     }
 
     void Parser::Assert(bool condition, string_view message)
@@ -59,6 +227,156 @@ namespace Zero
             Error(message);
     }
 
+    Parser::RecoveryPoint Parser::GetRecoveryPoint() const
+    {
+        return { Tell(), operand_stack.size(), operator_stack.size(), scopes.size() };
+    }
+
+    // Drops the operands, operators and scopes pushed since point.
+    void Parser::Unwind(const RecoveryPoint& point)
+    {
+        operand_stack.resize(point.operands);
+        operator_stack.resize(point.operators);
+        scopes.resize(point.scopes);
+        this_scope = !scopes.empty() ? scopes.back() : nullptr;
+    }
+
+    // Whether parsing can resume at a keyword after an error: it starts a declaration or statement and never continues one.
+    static bool IsRecoveryKeyword(Keyword keyword)
+    {
+        switch (keyword)
+        {
+        case Keyword::True:
+        case Keyword::False:
+        case Keyword::Nil:
+        case Keyword::Elif:
+        case Keyword::Else:
+        case Keyword::Do:
+        case Keyword::As:
+        case Keyword::MaxEnum:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // Drops whatever the failed statement left on the stacks, then skips to where the next one can start: past a semicolon, or
+    // before a closing brace or a statement keyword, at the bracket depth of the error. A stray closing brace at the top level is
+    // skipped too. The failed statement took at least its first token, so recovery always makes progress.
+    void Parser::Recover(const RecoveryPoint& point, bool top_level)
+    {
+        Unwind(point);
+
+        intptr depth = 0;
+        while (Tell() < tokens.Size())
+        {
+            auto type = this_token.type;
+            if (depth == 0)
+            {
+                if (type == TokenType::Semicolon)
+                {
+                    Accept();
+                    return;
+                }
+                if (type == TokenType::BraceRight)
+                {
+                    if (top_level)
+                        Accept();
+                    return;
+                }
+                if (type == TokenType::Keyword && Tell() != point.token && IsRecoveryKeyword(this_token.data.Get<Keyword>()))
+                    return;
+            }
+            if (type == TokenType::BraceLeft || type == TokenType::ParenLeft || type == TokenType::BracketLeft)
+                ++depth;
+            else if ((type == TokenType::BraceRight || type == TokenType::ParenRight || type == TokenType::BracketRight) && depth != 0)
+                --depth;
+            Accept();
+        }
+    }
+
+    // Prints the diagnostics in source order as path:line:column: message.
+    void Parser::ReportDiagnostics(FILE* out, string_view path) const
+    {
+        auto sorted = diagnostics;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Diagnostic& a, const Diagnostic& b) { return a.offset < b.offset; });
+        for (auto& e : sorted)
+        {
+            auto location = Locate(e.offset);
+            fprintf(out, "%.*s%s%u:%u: error: %s\n", (int)path.size(), path.data(), path.empty() ? "" : ":", location.line, location.column, e.message.c_str());
+        }
+        if (diagnostics.size() >= max_diagnostics)
+            fprintf(out, "Stopped after %u errors.\n", max_diagnostics);
+    }
+
+#ifdef ZERO_PARSER_PROFILE
+    static constexpr string_view ProductionNames[] =
+    {
+        "ParseExpressionsUntil",
+        "ParseTokenSeparatedSequence",
+        "ParseControlFlowExpressionBody",
+        "ParseRecord",
+        "ParseByUse",
+        "ParseByNamespace",
+        "ParseType",
+        "ParseByEnum",
+        "ParseTypeDecl",
+        "ParseBranch",
+        "ParseSelect",
+        "ParseWhile",
+        "ParseDoWhile",
+        "ParseFor",
+        "ParseScope",
+        "ParseBracket",
+        "ParseParenthesis",
+        "ParseFunctionBody",
+        "ParseFunction",
+        "ParseFactors",
+        "ParseOperators",
+        "ParseImpl",
+        "ParseNext",
+    };
+
+    static_assert(std::size(ProductionNames) == (uintptr)Parser::Production::MaxEnum);
+
+    // Prints the productions that were called, the most cycles first. Shares are of the cycles spent in ParseNext, which encloses
+    // everything ParseFile parses.
+    void Parser::ReportProfile(FILE* out, bool json) const
+    {
+        vector<uintptr> order;
+        for (uintptr i = 0; i != profile.size(); ++i)
+            if (profile[i].calls != 0)
+                order.push_back(i);
+        std::stable_sort(order.begin(), order.end(), [&](uintptr a, uintptr b) { return profile[a].cycles > profile[b].cycles; });
+
+        if (json)
+        {
+            fprintf(out, "[\n");
+            for (auto i : order)
+            {
+                auto& e = profile[i];
+                auto name = ProductionNames[i];
+                fprintf(out, "  { \"production\": \"%.*s\", \"calls\": %llu, \"tokens\": %llu, \"cycles\": %llu, \"nodes\": %llu }%s\n",
+                    (int)name.size(), name.data(), (unsigned long long)e.calls, (unsigned long long)e.tokens, (unsigned long long)e.cycles,
+                    (unsigned long long)e.nodes, i != order.back() ? "," : "");
+            }
+            fprintf(out, "]\n");
+            return;
+        }
+
+        auto total = std::max<uint64>(profile[(uintptr)Production::Next].cycles, 1);
+        fprintf(out, "%-32s %12s %12s %16s %7s %12s %10s\n", "production", "calls", "tokens", "cycles", "share", "nodes", "cyc/token");
+        for (auto i : order)
+        {
+            auto& e = profile[i];
+            auto name = ProductionNames[i];
+            fprintf(out, "%-32.*s %12llu %12llu %16llu %6.1f%% %12llu %10.1f\n",
+                (int)name.size(), name.data(), (unsigned long long)e.calls, (unsigned long long)e.tokens, (unsigned long long)e.cycles,
+                100.0 * e.cycles / total, (unsigned long long)e.nodes, (double)e.cycles / std::max<uint64>(e.tokens, 1));
+        }
+    }
+#endif
+
     void Parser::EnterScope(Scope* scope)
     {
         this_scope = scope;
@@ -78,13 +396,26 @@ namespace Zero
         scope->declarations.insert({ declaration->name, declaration });
     }
 
+    // Every statement is a recovery point: one with an error is left out and parsing resumes with the next. Running into the end of
+    // the file is left to the enclosing recovery point.
     vector<Expression> Parser::ParseExpressionsUntil(TokenType terminator)
     {
+        PROFILE_PRODUCTION(ExpressionsUntil);
         vector<Expression> r;
         while (this_token.type != terminator)
         {
-            r.push_back(Parse());
-            Accept(TokenType::Semicolon);
+            if (Tell() >= tokens.Size())
+                Error("Unexpected end of file.");
+            auto point = GetRecoveryPoint();
+            try
+            {
+                r.push_back(Parse());
+                Accept(TokenType::Semicolon);
+            }
+            catch (const SyntaxError&)
+            {
+                Recover(point, false);
+            }
         }
         Accept();
         return r;
@@ -92,13 +423,24 @@ namespace Zero
 
     vector<Expression> Parser::ParseExpressionsUntil(TokenType terminator, Expression::IndexT required_id)
     {
+        PROFILE_PRODUCTION(ExpressionsUntil);
         vector<Expression> r;
         while (this_token.type != terminator)
         {
-            auto e = Parse();
-            Assert(e.ID() == required_id, "");
-            r.push_back(std::move(e));
-            Accept(TokenType::Semicolon);
+            if (Tell() >= tokens.Size())
+                Error("Unexpected end of file.");
+            auto point = GetRecoveryPoint();
+            try
+            {
+                auto e = Parse();
+                Assert(e.ID() == required_id, "Unexpected kind of expression here.");
+                r.push_back(std::move(e));
+                Accept(TokenType::Semicolon);
+            }
+            catch (const SyntaxError&)
+            {
+                Recover(point, false);
+            }
         }
         Accept();
         return r;
@@ -106,6 +448,7 @@ namespace Zero
 
     vector<Expression> Parser::ParseTokenSeparatedSequence(TokenType separator)
     {
+        PROFILE_PRODUCTION(TokenSeparatedSequence);
         vector<Expression> r;
         while (true)
         {
@@ -119,6 +462,7 @@ namespace Zero
 
     vector<Expression> Parser::ParseTokenSeparatedSequence(TokenType separator, TokenType terminator)
     {
+        PROFILE_PRODUCTION(TokenSeparatedSequence);
         vector<Expression> r;
 
         if (this_token.type != terminator)
@@ -128,7 +472,7 @@ namespace Zero
                 r.push_back(Parse());
                 if (this_token.type == terminator)
                     break;
-                ExpectAndAccept(separator, "");
+                ExpectAndAccept(separator, "Expected a separator or the end of the list.");
             }
         }
         Accept();
@@ -137,6 +481,7 @@ namespace Zero
 
     vector<Expression> Parser::ParseTokenSeparatedSequence(TokenType separator, TokenType terminator, Expression::IndexT required_id)
     {
+        PROFILE_PRODUCTION(TokenSeparatedSequence);
         vector<Expression> r;
 
         if (this_token.type == terminator)
@@ -145,42 +490,44 @@ namespace Zero
         while (true)
         {
             auto e = Parse();
-            Assert(e.ID() == required_id, "");
+            Assert(e.ID() == required_id, "Unexpected kind of expression here.");
             r.push_back(std::move(e));
             if (this_token.type == terminator)
             {
                 Accept();
                 return r;
             }
-            ExpectAndAccept(separator, "");
+            ExpectAndAccept(separator, "Expected a separator or the end of the list.");
         }
     }
 
     Expression Parser::ParseControlFlowExpressionBody()
     {
+        PROFILE_PRODUCTION(ControlFlowExpressionBody);
         switch (this_token.type)
         {
         case TokenType::Keyword:
-            Assert(this_token.data.Get<Keyword>() == Keyword::Do, "");
+            Assert(this_token.data.Get<Keyword>() == Keyword::Do, "Expected 'do' or a braced body.");
             Accept();
             return Parse();
         case TokenType::BraceLeft:
             return Parse();
         default:
-            Error("");
+            Error("Expected 'do' or a braced body.");
         }
     }
 
     Expression Parser::ParseGenericRecord()
     {
-        abort();
+        Error("Generic records are not supported yet.");
     }
 
     Expression Parser::ParseRecord(optional<Identifier> name)
     {
+        PROFILE_PRODUCTION(Record);
         Record r = {};
 
-        ExpectAndAccept(TokenType::BraceRight, "");
+        ExpectAndAccept(TokenType::BraceRight, "Expected '}'.");
         r.fields = CastExpressionList<Declaration>(ParseExpressionsUntil(TokenType::BraceRight, Expression::IDOf<Declaration>));
 
         if (!name.has_value())
@@ -200,39 +547,87 @@ namespace Zero
             return default_value;
         Accept();
         auto v = Parse();
-        assert(v.Is<LiteralInt>());
-        ExpectAndAccept(TokenType::ParenRight, "");
+        Assert(v.Is<LiteralInt>(), "Expected the bit width as an integer literal.");
+        ExpectAndAccept(TokenType::ParenRight, "Expected ')' after the bit width.");
         return v.Get<LiteralInt>().value;
     }
 
+    // Each module path also goes into this_module.dependencies as written, a view of the source from its first token to the end of
+    // its last one.
     Use Parser::ParseByUse()
     {
+        PROFILE_PRODUCTION(ByUse);
         Use r = {};
-        r.modules = ParseTokenSeparatedSequence(TokenType::Comma);
+        while (true)
+        {
+            auto first = Tell();
+            r.modules.push_back(Parse());
+
+            auto last = std::min(Tell(), tokens.Size()); // A use at the end of the file leaves the parser past it.
+            while (last > first && tokens.Type(last - 1) == TokenType::Semicolon)
+                --last;
+            if (last != first)
+            {
+                auto begin = tokens.Offset(first);
+                auto path = tokens.source.substr(begin, tokens.offsets[last - 1] + tokens.sizes[last - 1] - begin);
+                this_module.dependencies.insert(path);
+                use_paths.push_back({ begin, (uint32)path.size() });
+                if (on_use)
+                    on_use(path);
+            }
+
+            if (this_token.type != TokenType::Comma)
+                break;
+            Accept();
+        }
         Accept(TokenType::Semicolon);
         return r;
     }
 
+    // Every element is an item of its own like a top-level one, so that Reparse can replace one without touching the nodes of the
+    // others. What the elements looked at counts towards the item the namespace is in.
     Namespace Parser::ParseByNamespace()
     {
+        PROFILE_PRODUCTION(ByNamespace);
         Namespace r = {};
-        Expect(TokenType::Identifier, "");
-        r.name = GetIdentifierID(this_token.data.Get<string_view>());
+        Expect(TokenType::Identifier, "Expected the namespace name.");
+        r.name = this_token.data.Get<IdentifierID>();
+        Accept();
+        ExpectAndAccept(TokenType::BraceLeft, "Expected '{' after the namespace name.");
+        auto first = item_first;
+        auto offset = item_offset;
+        auto reach = scanned;
+        auto start = Tell();
+        scanned = 0;
+        Expression e;
+        while (ParseNextElement(e))
+        {
+            auto end = std::max(Tell(), scanned);
+            r.elements.push_back(std::move(e));
+            r.extents.push_back({ (uint32)(start - first), (uint32)(end - first) });
+            reach = std::max(reach, end);
+            start = Tell();
+            scanned = 0;
+        }
+        r.last = (uint32)(Tell() - first);
+        r.reach = (uint32)(std::max(Tell(), scanned) - first);
         Accept();
-        ExpectAndAccept(TokenType::BraceLeft, "");
-        r.elements = ParseExpressionsUntil(TokenType::BraceRight);
+        item_first = first;
+        item_offset = offset;
+        scanned = std::max(reach, scanned);
         return r;
     }
 
     Expression Parser::ParseType()
     {
+        PROFILE_PRODUCTION(Type);
         Expression r;
         
         optional<Identifier> name = std::nullopt;
 
         if (this_token.type == TokenType::Identifier)
         {
-            name = GetIdentifierID(this_token.data.Get<string_view>());
+            name = this_token.data.Get<IdentifierID>();
             Accept();
         }
 
@@ -240,11 +635,16 @@ namespace Zero
         switch (type)
         {
         case TokenType::Operator:
-            Assert(data.Get<Operator>() == Operator::Assign, "");
+        {
+            Assert(data.Get<Operator>() == Operator::Assign, "Expected '=', '{' or '(' after the type name.");
+            Assert(name.has_value(), "Expected a type name.");
             Accept();
-            r = Declaration(Expression(Type(MetaType())).ToPtr(), name.value(), Expression(Parse().GetType(*this)).ToPtr());
+            auto value = Parse().GetType(*this);
+            auto init = !value.IsEmpty() ? Expression(std::move(value)).ToPtr() : ScopedPtr<Expression>();
+            r = Declaration(Expression(Type(MetaType())).ToPtr(), name.value(), std::move(init));
             Accept(TokenType::Semicolon);
             break;
+        }
         case TokenType::BraceLeft:
             Accept();
             r = ParseRecord(name);
@@ -255,7 +655,7 @@ namespace Zero
             break;
         default:
             Accept(TokenType::Semicolon);
-            Assert(name.has_value(), "");
+            Assert(name.has_value(), "Expected a type name.");
             r = Declaration(Expression(Type()).ToPtr(), name.value());
             break;
         }
@@ -264,27 +664,29 @@ namespace Zero
 
     Declaration Parser::ParseByEnum()
     {
+        PROFILE_PRODUCTION(ByEnum);
         Declaration r;
         Enum e;
-        ExpectAndAccept(TokenType::Identifier, "");
-        r.name = GetIdentifierID(this_token.data.Get<string_view>());
+        Expect(TokenType::Identifier, "Expected the enum name.");
+        r.name = this_token.data.Get<IdentifierID>();
+        Accept();
         if (auto token = this_token; token.type == TokenType::Colon)
         {
             Accept();
             e.underlying_type = Parse().ToPtr();
         }
-        ExpectAndAccept(TokenType::BraceLeft, "");
+        ExpectAndAccept(TokenType::BraceLeft, "Expected '{' after the enum name.");
         while (this_token.type != TokenType::BraceRight)
         {
-            string_view name;
+            IdentifierID name = {};
             Operator op = {};
 
             Assert(PopMany(
                 std::make_tuple(TokenType::Identifier, &name),
                 std::make_tuple(TokenType::Operator, &op, [](Operator o) { return o == Operator::Assign; })),
-                "");
+                "Expected an enum value as 'name = value'.");
 
-            e.values.insert(std::make_pair(GetIdentifierID(name), Parse()));
+            e.values.insert(std::make_pair(name, Parse()));
 
             Accept(TokenType::Comma);
         }
@@ -295,13 +697,14 @@ namespace Zero
 
     Expression Parser::ParseTypeDecl(Type type)
     {
-        Declaration r = {};
-        if (!type.IsEmpty())
-            r.type = Expression(type).ToPtr();
+        PROFILE_PRODUCTION(TypeDecl);
         auto token = this_token;
         if (token.type != TokenType::Identifier)
             return type;
-        r.name = GetIdentifierID(token.data.Get<string_view>());
+        Declaration r = {};
+        if (!type.IsEmpty())
+            r.type = Expression(std::move(type)).ToPtr();
+        r.name = token.data.Get<IdentifierID>();
         Accept();
         if (auto [t, data] = this_token; t == TokenType::Operator && data.Get<Operator>() == Operator::Assign)
         {
@@ -310,12 +713,18 @@ namespace Zero
         }
         Accept(TokenType::Semicolon);
         if (r.type == nullptr || r.type->IsEmpty())
-            r.type = Expression(r.init->GetType(*this)).ToPtr();
+        {
+            // Without a type, the declaration is left without one until names are resolved too.
+            Assert(r.init != nullptr, "Expected '=' and a value to infer the type from.");
+            auto inferred = r.init->GetType(*this);
+            r.type = !inferred.IsEmpty() ? Expression(std::move(inferred)).ToPtr() : ScopedPtr<Expression>();
+        }
         return r;
     }
 
     Branch Parser::ParseBranch()
     {
+        PROFILE_PRODUCTION(Branch);
         Branch r = {};
 
         r.condition = Parse().ToPtr();
@@ -344,39 +753,42 @@ namespace Zero
 
     Select Parser::ParseSelect()
     {
+        PROFILE_PRODUCTION(Select);
         Select r = {};
         r.key = Parse().ToPtr();
-        ExpectAndAccept(TokenType::BraceLeft, "");
+        ExpectAndAccept(TokenType::BraceLeft, "Expected '{' after the select key.");
         while (this_token.type != TokenType::BraceRight)
         {
             auto [type, data] = this_token;
-            Assert(type == TokenType::Keyword, "");
+            Assert(type == TokenType::Keyword, "Expected 'if' or 'else' in select.");
             switch (data.Get<Keyword>())
             {
             case Keyword::If:
             {
                 Accept();
                 auto k = Parse();
-                ExpectAndAccept(TokenType::Colon, "");
+                ExpectAndAccept(TokenType::Colon, "Expected ':' after the case.");
                 auto v = Parse();
                 r.cases.insert({ std::move(k), std::move(v) });
                 break;
             }
             case Keyword::Else:
-                Assert(r.default_case == nullptr, "");
+                Assert(r.default_case == nullptr, "Select already has an else case.");
                 Accept();
-                ExpectAndAccept(TokenType::Colon, "");
+                ExpectAndAccept(TokenType::Colon, "Expected ':' after 'else'.");
                 r.default_case = Parse().ToPtr();
                 break;
             default:
-                Error("");
+                Error("Expected 'if' or 'else' in select.");
             }
         }
+        Accept();
         return r;
     }
 
     While Parser::ParseWhile()
     {
+        PROFILE_PRODUCTION(While);
         While r = {};
         r.condition = Parse().ToPtr();
         r.body = ParseControlFlowExpressionBody().ToPtr();
@@ -385,16 +797,18 @@ namespace Zero
 
     DoWhile Parser::ParseDoWhile()
     {
+        PROFILE_PRODUCTION(DoWhile);
         DoWhile r = {};
-        Expect(TokenType::BraceLeft, "");
+        Expect(TokenType::BraceLeft, "Expected '{' after 'do'.");
         r.body = Parse().ToPtr();
-        ExpectAndAccept(TokenType::Keyword, Keyword::While, "");
+        ExpectAndAccept(TokenType::Keyword, Keyword::While, "Expected 'while' after the body.");
         r.condition = Parse().ToPtr();
         return r;
     }
 
     Expression Parser::ParseFor()
     {
+        PROFILE_PRODUCTION(For);
         auto first = Parse();
         if (this_token.type == TokenType::Colon)
         {
@@ -418,6 +832,7 @@ namespace Zero
 
     Scope Parser::ParseScope()
     {
+        PROFILE_PRODUCTION(Scope);
         Scope r = {};
         EnterScope(&r);
         r.expressions = ParseExpressionsUntil(TokenType::BraceRight);
@@ -427,6 +842,7 @@ namespace Zero
 
     Expression Parser::ParseBracket()
     {
+        PROFILE_PRODUCTION(Bracket);
         Expression r;
         bool any_type = false;
         bool any_value = false;
@@ -439,51 +855,144 @@ namespace Zero
             any_value = any_value || !e.Is<Type>();
         }
 
-        ExpectAndAccept(TokenType::BracketRight, "");
+        ExpectAndAccept(TokenType::BracketRight, "Expected ']'.");
 
         Accept(TokenType::Semicolon);
 
         return r;
     }
 
+    // Parentheses mostly group a single expression. A function literal's parameters are only known to be parameters at the ':' or
+    // '->' after them, so the token after the matching ')' is looked up first, by a pass over the token types like SkipBraces. Each
+    // parenthesis is parsed once either way, where trying one reading and then the other doubled the work at every nesting level.
     Expression Parser::ParseParenthesis()
     {
-        Function r = {};
-        auto expressions = ParseTokenSeparatedSequence(TokenType::Comma, TokenType::ParenRight);
+        PROFILE_PRODUCTION(Parenthesis);
+        auto types = tokens.types.data();
+        auto size = tokens.Size();
+        auto next = TokenType::MaxEnum;
+        uintptr depth = 1;
+        for (auto i = Tell(); i < size; ++i)
+        {
+            depth += types[i] == TokenType::ParenLeft;
+            depth -= types[i] == TokenType::ParenRight;
+            if (depth == 0)
+            {
+                next = tokens.Type(i + 1);
+                scanned = std::max(scanned, std::min(i + 2, size));
+                break;
+            }
+        }
+        if (depth != 0)
+            scanned = std::max(scanned, size);
 
-        if (auto type = this_token.type; type != TokenType::Colon && type != TokenType::Arrow)
+        if (next != TokenType::Colon && next != TokenType::Arrow)
         {
-            Assert(expressions.size() == 1, "");
-            return expressions[0];
+            Assert(this_token.type != TokenType::ParenRight, "Expected a single expression in parentheses.");
+            auto e = Parse();
+            Assert(this_token.type != TokenType::Comma, "Expected a single expression in parentheses.");
+            ExpectAndAccept(TokenType::ParenRight, "Expected ')'.");
+            return e;
         }
 
-        r.params = std::move(expressions);
+        Function r = {};
+        r.params = ParseTokenSeparatedSequence(TokenType::Comma, TokenType::ParenRight);
 
         if (Accept(TokenType::Arrow))
             r.return_type = Parse().ToPtr();
 
-        ExpectAndAccept(TokenType::Colon, "");
+        ExpectAndAccept(TokenType::Colon, "Expected ':' before the function body.");
+
+        ParseFunctionBody(r);
+
+        return r;
+    }
+
+    // Index of the token after the brace at index and everything it encloses, or 0 if it is never closed. Comments, strings and
+    // chars are single tokens by now, so a brace inside one is never counted and the scan is a pass over the token types.
+    static uintptr MatchBrace(const TokenStream& tokens, uintptr index)
+    {
+        auto types = tokens.types.data();
+        auto size = tokens.Size();
+        uintptr depth = 0;
+        for (auto i = index; i != size; ++i)
+        {
+            depth += types[i] == TokenType::BraceLeft;
+            depth -= types[i] == TokenType::BraceRight;
+            if (depth == 0)
+                return i + 1;
+        }
+        return 0;
+    }
+
+    // MatchBrace for a brace that must be closed.
+    uintptr Parser::SkipBraces(uintptr index)
+    {
+        assert(tokens.Type(index) == TokenType::BraceLeft);
+        if (auto r = MatchBrace(tokens, index); r != 0)
+            return r;
+        scanned = std::max(scanned, tokens.Size());
+        Error(tokens.Offset(index), 1, "Unmatched brace.");
+    }
+
+    // The body after the colon, which is either parsed along with its return type or, with defer_bodies set and a braced body, only
+    // skipped and remembered by its token range.
+    void Parser::ParseFunctionBody(Function& r)
+    {
+        PROFILE_PRODUCTION(FunctionBody);
+        if (defer_bodies && this_token.type == TokenType::BraceLeft)
+        {
+            auto first = Tell();
+            auto last = SkipBraces(first);
+            r.body_first = (uint32)(first - item_first);
+            r.body_last = (uint32)(last - item_first);
+            Seek(last);
+            return;
+        }
 
         r.body = Parse().ToPtr();
 
+        // A return type that depends on names is left out until they are resolved.
         if (r.return_type == nullptr)
         {
-            if (r.body->Is<Scope>())
-            {
-                auto [success, type] = r.body->InferReturnType(*this);
-                r.return_type = Expression(type).ToPtr();
-            }
-            else
-            {
-                r.return_type = Expression(r.body->GetType(*this)).ToPtr();
-            }
+            auto type = r.body->Is<Scope>() ? r.body->InferReturnType(*this).second : r.body->GetType(*this);
+            if (!type.IsEmpty())
+                r.return_type = Expression(std::move(type)).ToPtr();
         }
+    }
 
-        return r;
+    // Parses a body skipped by ParseFunctionBody, nested functions included, then returns to the token the parser was at. item is
+    // the index of the top-level item the function is in. In a namespace, element is the first token of the element it is in from
+    // there, the extents' firsts added up on the way down. The body's range and the offsets of its nodes count from that token.
+    void Parser::ParseDeferredBody(Function& function, uintptr item, uint32 element)
+    {
+        if (!function.HasDeferredBody())
+            return;
+        auto resume = Tell();
+        auto defer = std::exchange(defer_bodies, false);
+        auto start = item_extents[item].first - token_base + element;
+        auto first = std::exchange(item_first, start);
+        auto offset = std::exchange(item_offset, tokens.Offset(start));
+        Seek(item_first + function.body_first);
+        function.body_first = function.body_last = 0;
+        auto point = GetRecoveryPoint();
+        try
+        {
+            ParseFunctionBody(function);
+        }
+        catch (const SyntaxError&)
+        {
+            Recover(point, false);
+        }
+        item_first = first;
+        item_offset = offset;
+        defer_bodies = defer;
+        Seek(resume);
     }
 
     Expression Parser::ParseFunction(optional<Identifier> name)
     {
+        PROFILE_PRODUCTION(Function);
         Function r = {};
 
         auto expressions = ParseTokenSeparatedSequence(TokenType::Comma, TokenType::ParenRight);
@@ -498,25 +1007,12 @@ namespace Zero
 
         if (this_token.type != TokenType::Colon)
         {
-            Assert(name.has_value(), "");
+            Assert(name.has_value(), "Expected ':' before the function body.");
             return FunctionCall(name.value(), std::move(r.params));
         }
 
         Accept();
-        r.body = Parse().ToPtr();
-
-        if (r.return_type == nullptr)
-        {
-            if (r.body->Is<Scope>())
-            {
-                auto [success, type] = r.body->InferReturnType(*this);
-                r.return_type = Expression(type).ToPtr();
-            }
-            else
-            {
-                r.return_type = Expression(r.body->GetType(*this)).ToPtr();
-            }
-        }
+        ParseFunctionBody(r);
 
         if (!name.has_value())
             return r;
@@ -528,15 +1024,18 @@ namespace Zero
         return d;
     }
 
-    Expression Parser::ParseFactors(Expression lhs)
+    // Whatever follows a leading identifier or literal. An operand of a binary operator stops before the next operator and leaves a
+    // semicolon for the whole expression to take.
+    Expression Parser::ParseFactors(Expression lhs, bool operand)
     {
+        PROFILE_PRODUCTION(Factors);
         Expression r;
         switch (this_token.type)
         {
         case TokenType::Keyword:
             if (this_token.data.Get<Keyword>() != Keyword::As)
             {
-                r = lhs;
+                r = std::move(lhs);
             }
             else
             {
@@ -548,7 +1047,7 @@ namespace Zero
         {
             Declaration d = {};
             d.type = lhs.ToPtr();
-            d.name = GetIdentifierID(this_token.data.Get<string_view>());
+            d.name = this_token.data.Get<IdentifierID>();
             Accept();
             auto [type, data] = this_token;
             if (type == TokenType::Operator && data.Get<Operator>() == Operator::Assign)
@@ -558,40 +1057,116 @@ namespace Zero
             }
             else if (type == TokenType::Identifier)
             {
-                abort();
+                Error("Expected '=' or the end of the declaration.");
             }
             r = std::move(d);
             break;
         }
         case TokenType::Operator:
-        {
-            const auto op = this_token.data.Get<Operator>();
-            Accept();
-            r = BinaryExpression(lhs.ToPtr(), Parse().ToPtr(), op);
+            if (operand)
+            {
+                r = std::move(lhs);
+            }
+            else
+            {
+                operand_stack.push_back(std::move(lhs));
+                r = ParseOperators(operator_stack.size());
+            }
             break;
-        }
         case TokenType::ParenLeft:
             Accept();
             if (lhs.Is<Identifier>())
                 r = ParseFunction(lhs.Get<Identifier>()); // Might be a function declaration!
             else
-                r = lhs;
+                r = std::move(lhs);
             break;
         case TokenType::Semicolon:
-            Accept();
+            if (!operand)
+                Accept();
             [[fallthrough]];
         default:
-            r = lhs;
+            r = std::move(lhs);
             break;
         }
-        Accept(TokenType::Semicolon);
+        if (!operand)
+            Accept(TokenType::Semicolon);
         return r;
     }
 
-    Expression Parser::Parse()
+    // Pushes the prefix operators of the next operand onto operator_stack, then the operand itself onto operand_stack.
+    void Parser::PushOperand()
+    {
+        while (this_token.type == TokenType::Operator)
+        {
+            auto op = Operator(this_token.data.Get<Operator>());
+            if (!OPERATOR_PRECEDENCE[(uint8)op].prefix)
+                break;
+            operator_stack.push_back({ op, PREFIX_PRECEDENCE, true, NodeOffset() });
+            Accept();
+        }
+
+        if (Tell() >= tokens.Size())
+            Error("Unexpected end of file.");
+        if (this_token.type == TokenType::MaxEnum)
+            Error("Invalid token.");
+        auto offset = NodeOffset();
+        auto& e = operand_stack.emplace_back(ParseImpl(true));
+        e.offset = offset;
+    }
+
+    // Applies the operator on top of operator_stack to the operands on top of operand_stack, in place of the last one.
+    void Parser::ReduceOperator()
+    {
+        auto top = operator_stack.back();
+        operator_stack.pop_back();
+        auto rhs = operand_stack.back().ToPtr();
+        if (top.unary)
+        {
+            operand_stack.back() = UnaryExpression(std::move(rhs), top.op);
+            operand_stack.back().offset = top.offset;
+            return;
+        }
+        operand_stack.pop_back();
+        auto& lhs = operand_stack.back();
+        auto offset = lhs.offset;
+        lhs = BinaryExpression(lhs.ToPtr(), std::move(rhs), top.op);
+        lhs.offset = offset;
+    }
+
+    // Precedence climbing over explicit stacks. The first operand and its prefix operators are already pushed; operators above
+    // operator_base are reduced as soon as an operator that binds looser follows them, so a chain of any length uses constant native
+    // stack and only parentheses and other nested expressions recurse.
+    Expression Parser::ParseOperators(uintptr operator_base)
     {
-        Accept(TokenType::MaxEnum);
+        PROFILE_PRODUCTION(Operators);
+        while (this_token.type == TokenType::Operator)
+        {
+            auto op = Operator(this_token.data.Get<Operator>());
+            auto info = OPERATOR_PRECEDENCE[(uint8)op];
+            if (info.binary == 0)
+                break;
+            while (operator_stack.size() != operator_base)
+            {
+                auto top = operator_stack.back().precedence;
+                if (top < info.binary || (top == info.binary && info.right_assoc))
+                    break;
+                ReduceOperator();
+            }
+            operator_stack.push_back({ op, info.binary, false, NodeOffset() });
+            Accept();
+            PushOperand();
+        }
+
+        while (operator_stack.size() != operator_base)
+            ReduceOperator();
+        auto r = std::move(operand_stack.back());
+        operand_stack.pop_back();
+        return r;
+    }
 
+    Expression Parser::ParseImpl(bool operand)
+    {
+        PROFILE_PRODUCTION(Impl);
         auto [type, data] = this_token;
         Accept();
         switch (type)
@@ -608,11 +1183,11 @@ namespace Zero
             case Keyword::Enum:
                 return ParseByEnum();
             case Keyword::True:
-                return ParseFactors(LiteralBool(true));
+                return ParseFactors(LiteralBool(true), operand);
             case Keyword::False:
-                return ParseFactors(LiteralBool(false));
+                return ParseFactors(LiteralBool(false), operand);
             case Keyword::Nil:
-                return ParseFactors(LiteralNil());
+                return ParseFactors(LiteralNil(), operand);
             case Keyword::Void:
                 return ParseTypeDecl(Void());
             case Keyword::Let:
@@ -636,40 +1211,51 @@ namespace Zero
             case Keyword::For:
                 return ParseFor();
             case Keyword::Break:
+                if (!operand)
+                    Accept(TokenType::Semicolon);
                 return Break();
             case Keyword::Continue:
+                if (!operand)
+                    Accept(TokenType::Semicolon);
                 return Continue();
             case Keyword::Defer:
                 return Defer(Parse().ToPtr());
             case Keyword::Return:
+                if (this_token.type == TokenType::Semicolon || this_token.type == TokenType::BraceRight)
+                {
+                    // Returns nothing, see Return::InferReturnType.
+                    if (!operand)
+                        Accept(TokenType::Semicolon);
+                    return Return(ScopedPtr<Expression>());
+                }
                 return Return(Parse().ToPtr());
             case Keyword::Yield:
                 return Yield(Parse().ToPtr());
             default:
-                Error("");
+                Error(tokens.Offset(Tell() - 1), tokens.sizes[Tell() - 1], "Unexpected keyword.");
             }
             break;
         case TokenType::Identifier:
-            return ParseFactors(Identifier(GetIdentifierID(data.Get<string_view>())));
+            return ParseFactors(Identifier(data.Get<IdentifierID>()), operand);
         case TokenType::LiteralInt:
-            return ParseFactors(LiteralInt(data.Get<uint64>()));
+            if (data.Is<BigInt>())
+                return ParseFactors(LiteralBigInt(data.Get<BigInt>()), operand);
+            return ParseFactors(LiteralInt(data.Get<uint64>()), operand);
         case TokenType::LiteralReal:
-            return ParseFactors(LiteralReal(data.Get<double>()));
+            return ParseFactors(LiteralReal(data.Get<double>()), operand);
         case TokenType::Operator:
         {
-            auto op = data.Get<Operator>();
-            switch (op)
-            {
-            case Operator::Add:
-            case Operator::Sub:
-            case Operator::Complement:
-            case Operator::Increment:
-            case Operator::Decrement:
-            case Operator::BoolNot:
-                return UnaryExpression{ Parse().ToPtr(), op };
-            default:
-                Error("");
-            }
+            // A prefix operator starts an operator expression, its operand and any binary operators after it go on the stacks.
+            auto op = Operator(data.Get<Operator>());
+            if (!OPERATOR_PRECEDENCE[(uint8)op].prefix)
+                Error(tokens.Offset(Tell() - 1), tokens.sizes[Tell() - 1], "Not a prefix operator.");
+            auto base = operator_stack.size();
+            operator_stack.push_back({ op, PREFIX_PRECEDENCE, true, tokens.Offset(Tell() - 1) - item_offset });
+            PushOperand();
+            auto r = ParseOperators(base);
+            if (!operand)
+                Accept(TokenType::Semicolon);
+            return r;
         }
         case TokenType::Wildcard:
             return Wildcard();
@@ -678,9 +1264,15 @@ namespace Zero
         case TokenType::BracketLeft:
             return ParseBracket();
         case TokenType::ParenLeft:
-            return ParseParenthesis();
+        {
+            // A group is an operand like any other, so operators after the ')' go on with it. A function literal ends at its body.
+            auto r = ParseParenthesis();
+            if (r.Is<Function>())
+                return r;
+            return ParseFactors(std::move(r), operand);
+        }
         case TokenType::Comma:
-            abort();
+            break;
         case TokenType::Colon:
             break;
         case TokenType::Semicolon:
@@ -690,20 +1282,540 @@ namespace Zero
         case TokenType::Address:
             break;
         default:
-            return Expression();
+            if (Tell() - 1 >= tokens.Size())
+                return Expression(); // The end of the file.
+            break;
         }
-        Error("");
+        Seek(Tell() - 1); // Give the token back, so that recovery sees a ; or } there.
+        Error(type != TokenType::MaxEnum ? "Unexpected token." : "Invalid token.");
+    }
+
+    Expression Parser::Parse()
+    {
+        if (this_token.type == TokenType::MaxEnum && Tell() < tokens.Size())
+            Error("Invalid token.");
+
+        auto offset = NodeOffset();
+        auto r = ParseImpl();
+        r.offset = offset;
+        return r;
     }
 
-    Module Parser::ParseFile()
+    // Pull-style streaming: parses the next top-level item into out, returns false at the end of the file. Every item is a recovery
+    // point, one with an error is left out and the next one is returned instead.
+    bool Parser::ParseNext(Expression& out)
     {
+        PROFILE_PRODUCTION(Next);
+        item_first = Tell();
+        item_offset = Offset();
         while (true)
         {
-            auto e = Parse();
-            if (e.IsEmpty())
-                break;
+            auto point = GetRecoveryPoint();
+            try
+            {
+                out = Parse();
+                return !out.IsEmpty();
+            }
+            catch (const SyntaxError&)
+            {
+                Recover(point, true);
+            }
+        }
+    }
+
+    // ParseNext for the elements of a namespace, returns false at its closing brace, which is left for the namespace. An element
+    // with an error is left out the same way, only recovery stops before a closing brace instead of taking it.
+    bool Parser::ParseNextElement(Expression& out)
+    {
+        item_first = Tell();
+        item_offset = Offset();
+        while (this_token.type != TokenType::BraceRight)
+        {
+            if (Tell() >= tokens.Size())
+                Error("Unexpected end of file.");
+            auto point = GetRecoveryPoint();
+            try
+            {
+                out = Parse();
+                Accept(TokenType::Semicolon);
+                return true;
+            }
+            catch (const SyntaxError&)
+            {
+                Recover(point, false);
+            }
+        }
+        return false;
+    }
+
+    // The module stays in the parser for Reparse and ParseDeferredBody, move it out to keep it past the parser. Declarations are
+    // registered by address, so a copy of it would still point into this one; Clone the expressions that are really needed twice.
+    Module& Parser::ParseFile()
+    {
+        auto copies = Detail::scoped_ptr_copies;
+        Expression e;
+        item_extents.clear();
+        auto first = Tell();
+        scanned = 0;
+        while (ParseNext(e))
+        {
             this_module.global_scope.expressions.push_back(std::move(e));
+            item_extents.push_back({ (uint32)first, (uint32)std::max(Tell(), scanned) });
+            first = Tell();
+            scanned = 0;
+        }
+        deep_copies = Detail::scoped_ptr_copies - copies;
+        assert(deep_copies == 0);
+#ifdef ZERO_PARSER_PROFILE
+        if (profile_out != nullptr)
+            ReportProfile(profile_out, profile_json);
+#endif
+        return this_module;
+    }
+
+    // Whether the token at index can only begin a new top-level item, never continue the one before it.
+    static bool StartsItem(const TokenStream& tokens, uintptr index)
+    {
+        switch (tokens.Type(index))
+        {
+        case TokenType::Identifier:
+            return true;
+        case TokenType::Keyword:
+            switch ((Keyword)tokens.payloads[index])
+            {
+            case Keyword::Pragma:
+            case Keyword::Use:
+            case Keyword::Namespace:
+            case Keyword::Type:
+            case Keyword::Enum:
+            case Keyword::Void:
+            case Keyword::Let:
+            case Keyword::Bool:
+            case Keyword::Int:
+            case Keyword::UInt:
+            case Keyword::Float:
+                return true;
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    }
+
+    // Likely token indices where top-level items start, found by bracket depth alone: an item ends at a ; or closing brace at depth
+    // zero if a new one begins right after it, except for the ; inside a for header, which runs up to its do or body. Items that
+    // are not separated that way are simply kept together. This is only a guess, ParseFileParallel confirms each split.
+    static vector<uintptr> FindTopLevelItems(const TokenStream& tokens, uintptr first)
+    {
+        vector<uintptr> r;
+        r.push_back(first);
+        auto types = tokens.types.data();
+        intptr depth = 0;
+        bool header = false;
+        for (auto i = first; i < tokens.Size(); ++i)
+        {
+            auto type = types[i];
+            if (depth == 0 && type == TokenType::Keyword)
+            {
+                auto keyword = (Keyword)tokens.payloads[i];
+                header = keyword == Keyword::For || (header && keyword != Keyword::Do);
+            }
+            header &= depth != 0 || type != TokenType::BraceLeft;
+            depth += type == TokenType::BraceLeft || type == TokenType::ParenLeft || type == TokenType::BracketLeft;
+            depth -= type == TokenType::BraceRight || type == TokenType::ParenRight || type == TokenType::BracketRight;
+            if (depth == 0 && !header && (type == TokenType::Semicolon || type == TokenType::BraceRight) && StartsItem(tokens, i + 1))
+                r.push_back(i + 1);
+        }
+        return r;
+    }
+
+    namespace Detail
+    {
+        // A run of whole top-level items, parsed by a worker on its own slice of the token stream.
+        struct ParseChunk
+        {
+            uintptr first;
+            uintptr last;
+            vector<Expression> expressions;
+            vector<ItemExtent> item_extents;
+            vector<Parser::UsePath> use_paths;
+            HashMap<string_view> dependencies;
+            vector<Diagnostic> diagnostics;
+            uint64 deep_copies;
+            bool ends_item;		// Whether the chunk ends with an item that parsed without errors, so ParseFile would start a new one after it too.
+#ifdef ZERO_PARSER_PROFILE
+            decltype(Parser::profile) profile;
+#endif
+
+            void Parse(const Parser& parent)
+            {
+                TokenStream slice;
+                slice.Slice(parent.tokens, first, last);
+                Parser parser(std::move(slice), parent.token_base + first);
+                parser.ptr_size = parent.ptr_size;
+                parser.defer_bodies = parent.defer_bodies;
+                parser.on_use = parent.on_use;
+                parser.max_diagnostics = parent.max_diagnostics;
+                auto copies = Detail::scoped_ptr_copies;
+                auto start = parser.Tell();
+                uintptr reported = 0;
+                parser.ParseEach([&](Expression&& e)
+                {
+                    expressions.push_back(std::move(e));
+                    item_extents.push_back({ (uint32)(first + start), (uint32)(first + std::max(parser.Tell(), parser.scanned)) });
+                    start = parser.Tell();
+                    parser.scanned = 0;
+                    reported = parser.diagnostics.size();
+                });
+
+                // An item cut off by the end of the chunk fails at the end of the slice, and recovery from an error after the last
+                // item may have skipped further in the whole file. Errors recovered from before an item parsed are fine, that item
+                // starts where ParseFile would start it too.
+                ends_item = start == parser.tokens.Size() && parser.diagnostics.size() == reported;
+                use_paths = std::move(parser.use_paths);
+                dependencies = std::move(parser.this_module.dependencies);
+                diagnostics = std::move(parser.diagnostics);
+                deep_copies = Detail::scoped_ptr_copies - copies;
+#ifdef ZERO_PARSER_PROFILE
+                profile = parser.profile;
+#endif
+            }
+        };
+    }
+
+    // ParseFile on several threads. The file is split between likely top-level items into a few chunks per thread, workers take
+    // chunks in turn and the results are appended in source order, so the module is the same as ParseFile's. A split the parse
+    // doesn't confirm, where a chunk's last item fails or reaches past it, throws the chunks away and parses the file with
+    // ParseFile instead, so on_use may be called twice for the same use. That costs the whole parallel parse on top of ParseFile's,
+    // so a file with an error in one of the few items that end a chunk parses slower than with ParseFile alone. on_use may be
+    // called from any of the threads. AST nodes come from the per-thread caches of the ScopedPtr pools, so workers seldom contend
+    // on an allocator and hand their caches back when they exit. A profile adds up the workers' cycles, not wall time.
+    Module& Parser::ParseFileParallel(uint32 thread_count)
+    {
+        using Detail::ParseChunk;
+
+        if (thread_count == 0)
+            thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+        auto first = Tell();
+        auto size = tokens.Size();
+        auto items = FindTopLevelItems(tokens, first);
+        auto chunk_count = std::min<uintptr>({ (uintptr)thread_count * 4, items.size(), (size - std::min(first, size)) / MinParallelChunkTokens });
+        if (thread_count == 1 || chunk_count < 2)
+            return ParseFile();
+
+        vector<ParseChunk> chunks;
+        chunks.reserve(chunk_count);
+        auto prior = first;
+        for (uintptr i = 1; i <= chunk_count; ++i)
+        {
+            auto last = size;
+            if (i != chunk_count)
+            {
+                auto it = std::lower_bound(items.begin(), items.end(), first + (size - first) * i / chunk_count);
+                last = it != items.end() ? *it : size;
+            }
+            if (last <= prior)
+                continue;
+            auto& chunk = chunks.emplace_back();
+            chunk.first = prior;
+            chunk.last = last;
+            prior = last;
+        }
+
+        std::atomic<uintptr> next_chunk = 0;
+        auto worker = [&]
+        {
+            for (auto i = next_chunk.fetch_add(1, std::memory_order_relaxed); i < chunks.size(); i = next_chunk.fetch_add(1, std::memory_order_relaxed))
+                chunks[i].Parse(*this);
+        };
+
+        vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (uint32 i = 1; i != thread_count; ++i)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& e : threads)
+            e.join();
+
+        if (std::any_of(chunks.begin(), chunks.end() - 1, [](const ParseChunk& e) { return !e.ends_item; }))
+            return ParseFile();
+
+        auto& expressions = this_module.global_scope.expressions;
+        uintptr total = expressions.size();
+        for (auto& e : chunks)
+            total += e.expressions.size();
+        expressions.reserve(total);
+        item_extents.clear();
+        item_extents.reserve(total);
+        deep_copies = 0;
+        for (auto& chunk : chunks)
+        {
+            deep_copies += chunk.deep_copies;
+            for (auto& e : chunk.expressions)
+                expressions.push_back(std::move(e));
+            item_extents.insert(item_extents.end(), chunk.item_extents.begin(), chunk.item_extents.end());
+            use_paths.insert(use_paths.end(), chunk.use_paths.begin(), chunk.use_paths.end());
+            this_module.dependencies.insert(chunk.dependencies.begin(), chunk.dependencies.end());
+            for (auto& e : chunk.diagnostics)
+                if (diagnostics.size() < max_diagnostics)
+                    diagnostics.push_back(std::move(e));
+#ifdef ZERO_PARSER_PROFILE
+            for (uintptr i = 0; i != profile.size(); ++i)
+            {
+                profile[i].calls += chunk.profile[i].calls;
+                profile[i].tokens += chunk.profile[i].tokens;
+                profile[i].cycles += chunk.profile[i].cycles;
+                profile[i].nodes += chunk.profile[i].nodes;
+            }
+#endif
+        }
+        Seek(size);
+        assert(deep_copies == 0);
+#ifdef ZERO_PARSER_PROFILE
+        if (profile_out != nullptr)
+            ReportProfile(profile_out, profile_json);
+#endif
+        return this_module;
+    }
+
+    namespace Detail
+    {
+        // One Reparse, on every level of items it goes down to: the edit in bytes and as Relex saw it, and the byte range of the old
+        // source whose items were parsed again. The diagnostics and uses found before that range stay, the ones after it move.
+        struct Reparsing
+        {
+            Parser& parser;
+            TextEdit bytes;
+            TokenEdit edit;
+            uint32 byte_delta;
+            uint32 replaced_first;
+            uint32 replaced_last;
+            uintptr rest;		// What the tokens after the last element looked at, if Items parsed them again.
+
+            // Where a token, or a token count from one before the edit, is after it.
+            uint32 Moved(uintptr old_index) const
+            {
+                return (uint32)(old_index + edit.inserted - edit.removed);
+            }
+
+            // Parses again the items the edit reached, the global scope's or a namespace's elements, whose extents count from
+            // base. Parsing starts at the first one that looked at a replaced token, or at start if there are none, and stops once an
+            // item would start at a token an old item started at after the edit; from there on the old items are kept and only
+            // their extents move. Elements end at the old closing brace close, they are given up on if they don't end at the same
+            // brace after the edit, then the namespace is parsed again as a whole. close is 0 for the global scope.
+            bool Items(vector<Expression>& items, vector<ItemExtent>& extents, uintptr base, uintptr start, uintptr close)
+            {
+                auto first = edit.first;
+                auto removed = edit.removed;
+                auto n = items.size();
+                uintptr a = 0;
+                while (a < n && base + extents[a].reach < first)
+                    ++a;
+                if (a == n && n != 0)
+                    --a; // Only the tokens after the last item changed, which it looked at too.
+                auto b = n != 0 ? a + 1 : 0;
+                while (b < n && base + extents[b].first < first + removed)
+                    ++b;
+
+                if (b == a + 1 && (Body(items[a], extents[a], base) || Elements(items[a], extents[a], base, close != 0)))
+                {
+                    for (auto i = b; i < n; ++i)
+                        extents[i] = { Moved(extents[i].first), Moved(extents[i].reach) };
+                    return true;
+                }
+
+                auto diagnostic_count = parser.diagnostics.size();
+                auto use_count = parser.use_paths.size();
+                vector<Expression> parsed;
+                vector<ItemExtent> parsed_extents;
+                if (n != 0)
+                    start = base + extents[a].first;
+                auto from = start;
+                auto lost = false;
+                rest = 0;
+                parser.Seek(start);
+                parser.scanned = 0;
+                try
+                {
+                    while (true)
+                    {
+                        while (b < n && Moved(base + extents[b].first) < start)
+                            ++b;
+                        if (b < n && Moved(base + extents[b].first) == start)
+                            break;
+                        Expression e;
+                        if (!(close != 0 ? parser.ParseNextElement(e) : parser.ParseNext(e)))
+                        {
+                            b = n;
+                            rest = std::max(parser.Tell(), parser.scanned);
+                            break;
+                        }
+                        parsed.push_back(std::move(e));
+                        parsed_extents.push_back({ (uint32)(start - base), (uint32)(std::max(parser.Tell(), parser.scanned) - base) });
+                        start = parser.Tell();
+                        parser.scanned = 0;
+                    }
+                }
+                catch (const Parser::SyntaxError&)
+                {
+                    lost = true; // Elements ran into the end of the file, their closing brace is gone.
+                }
+                if (lost || (close != 0 && b == n && parser.Tell() != Moved(close)))
+                {
+                    parser.diagnostics.resize(diagnostic_count);
+                    parser.use_paths.resize(use_count);
+                    return false;
+                }
+
+                // The first token parsed again is the one Relex started at or one before it. Either way the bytes of the old
+                // source before the edit are where they were.
+                auto& tokens = parser.tokens;
+                replaced_first = n != 0 || close != 0 ? std::min(tokens.Offset(from), bytes.offset) : 0;
+                if (b < n)
+                    replaced_last = tokens.Offset(Moved(base + extents[b].first)) - byte_delta;
+                else if (close != 0)
+                    replaced_last = tokens.Offset(Moved(close) + 1) - byte_delta; // Errors before the brace are reported at it.
+                else
+                    replaced_last = UINT32_MAX;
+
+                for (auto i = b; i < n; ++i)
+                    extents[i] = { Moved(extents[i].first), Moved(extents[i].reach) };
+
+                // Most edits replace as many items as they leave, then nothing after them has to move.
+                auto common = std::min(parsed.size(), b - a);
+                std::move(parsed.begin(), parsed.begin() + common, items.begin() + a);
+                std::copy(parsed_extents.begin(), parsed_extents.begin() + common, extents.begin() + a);
+                items.erase(items.begin() + a + common, items.begin() + b);
+                extents.erase(extents.begin() + a + common, extents.begin() + b);
+                items.insert(items.begin() + a + common, std::make_move_iterator(parsed.begin() + common), std::make_move_iterator(parsed.end()));
+                extents.insert(extents.begin() + a + common, parsed_extents.begin() + common, parsed_extents.end());
+                return true;
+            }
+
+            // An edit inside the braces of a namespace that starts its item, which is an element itself if element is set, only
+            // reaches the elements. What the item looked at is then what they did, or up to the token after its closing brace and
+            // the semicolon an element takes after that.
+            bool Elements(Expression& item, ItemExtent& extent, uintptr base, bool element)
+            {
+                if (!item.Is<Namespace>() || item.offset != 0)
+                    return false;
+                auto& r = item.Get<Namespace>();
+                auto first = base + extent.first;
+                auto close = first + r.last;
+                auto elements_first = first + 3; // After namespace, its name and {.
+                if (edit.first < elements_first || edit.first + edit.removed > close)
+                    return false;
+                rest = 0;
+                if (!Items(r.elements, r.extents, first, elements_first, close))
+                    return false;
+
+                auto parsed_rest = std::exchange(rest, 0);
+                r.last = Moved(r.last);
+                r.reach = parsed_rest != 0 ? (uint32)(parsed_rest - first) : Moved(r.reach);
+                auto end = (uintptr)Moved(close) + 1;
+                if (element && parser.tokens.Type(end) == TokenType::Semicolon)
+                    ++end;
+                auto reach = std::max<uintptr>(end, first + r.reach);
+                for (auto& e : r.extents)
+                    reach = std::max<uintptr>(reach, first + e.reach);
+                extent.reach = (uint32)(reach - base);
+                return true;
+            }
+
+            // An edit inside a body ParseFunctionBody skipped, of a function that is the item or that it declares, needs nothing
+            // parsed as long as the body still ends at the same brace. Nothing else in the item looked into the body: the item
+            // parsed without errors, and whatever it put in parentheses before the body ends there.
+            bool Body(Expression& item, ItemExtent& extent, uintptr base)
+            {
+                if (item.offset != 0)
+                    return false;
+                Function* function = nullptr;
+                if (item.Is<Function>())
+                    function = &item.Get<Function>();
+                else if (item.Is<Declaration>() && item.Get<Declaration>().init != nullptr && item.Get<Declaration>().init->Is<Function>())
+                    function = &item.Get<Declaration>().init->Get<Function>();
+                if (function == nullptr || !function->HasDeferredBody())
+                    return false;
+
+                auto& tokens = parser.tokens;
+                auto first = base + extent.first;
+                auto body_first = first + function->body_first;
+                auto body_last = first + function->body_last;
+                if (edit.first < body_first || edit.first + edit.removed >= body_last)
+                    return false; // The edit reaches a brace of the body, or past it.
+                if (tokens.Type(body_first) != TokenType::BraceLeft || MatchBrace(tokens, body_first) != Moved(body_last))
+                    return false;
+
+                function->body_last = Moved(function->body_last);
+                extent.reach = Moved(extent.reach);
+                replaced_first = replaced_last = std::min(tokens.Offset(body_first), bytes.offset);
+                return true;
+            }
+        };
+    }
+
+    // Brings this_module, as parsed by ParseFile, up to date with text, the source after edit. Only the items the edit reached are
+    // parsed again, see Detail::Reparsing::Items. An edit inside a namespace goes down to its elements, which are items of their own,
+    // and one inside a body that defer_bodies skipped only moves the end of the body, so a keystroke costs about one element's parse
+    // or one skip of a body plus a pass over the extents after it on every level. The module is updated in place rather than
+    // copied out like ParseFile does. Like Relex, text must not be the buffer the parser was reading.
+    const Module& Parser::Reparse(string_view text, const TextEdit& edit, bool padded)
+    {
+        assert(token_base == 0);
+
+        auto copies = Detail::scoped_ptr_copies;
+        auto& expressions = this_module.global_scope.expressions;
+        if (item_extents.size() != expressions.size() || diagnostics.size() >= max_diagnostics)
+        {
+            // Not from ParseFile, or it stopped at max_diagnostics and left the rest out, so nothing is known to be reusable.
+            expressions.clear();
+            item_extents.clear();
+        }
+
+        auto old_diagnostics = std::move(diagnostics);
+        auto old_use_paths = std::move(use_paths);
+        diagnostics.clear();
+        use_paths.clear();
+        auto byte_delta = edit.inserted - edit.removed;
+        Detail::Reparsing reparsing = { *this, edit, tokens.Relex(text, edit, padded), byte_delta, 0, 0, 0 };
+        reparsing.Items(expressions, item_extents, 0, 0, 0);
+
+        auto replaced_first = reparsing.replaced_first;
+        auto replaced_last = reparsing.replaced_last;
+        for (auto& e : old_diagnostics)
+        {
+            if (e.offset < replaced_first)
+                diagnostics.push_back(std::move(e));
+            else if (e.offset >= replaced_last)
+                diagnostics.push_back({ e.offset + byte_delta, e.size, std::move(e.message) });
         }
+        auto reparsed_use_paths = std::move(use_paths);
+        use_paths.clear();
+        for (auto e : old_use_paths)
+            if (e.offset < replaced_first)
+                use_paths.push_back(e);
+        use_paths.insert(use_paths.end(), reparsed_use_paths.begin(), reparsed_use_paths.end());
+        for (auto e : old_use_paths)
+            if (e.offset >= replaced_last)
+                use_paths.push_back({ e.offset + byte_delta, e.size });
+        if (diagnostics.size() >= max_diagnostics)
+        {
+            // ParseFile would stop here, which no kept item can tell, so the whole file is parsed again.
+            expressions.clear();
+            item_extents.clear();
+            diagnostics.clear();
+            use_paths.clear();
+            reparsing.Items(expressions, item_extents, 0, 0, 0);
+        }
+        this_module.dependencies.clear();
+        for (auto e : use_paths)
+            this_module.dependencies.insert(tokens.source.substr(e.offset, e.size));
+
+        Seek(tokens.Size());
+        deep_copies = Detail::scoped_ptr_copies - copies;
+        assert(deep_copies == 0);
         return this_module;
     }
 }
\ No newline at end of file
@@ -3,11 +3,26 @@
 #include "AST.hpp"
 #include "Module.h"
 #include "Tokenizer.hpp"
+#include "TokenStream.hpp"
+#include "SourceFile.hpp"
+#include <functional>
+#include <cstdio>
+#include <array>
 
 
 
 namespace Zero
 {
+	// A syntax error at [offset, offset + size) of the source.
+	struct Diagnostic
+	{
+		uint32 offset;
+		uint32 size;
+		string message;
+	};
+
+
+
 	struct Parser
 	{
 		struct TokenInfo
@@ -18,24 +33,125 @@ namespace Zero
 			constexpr bool HasData() const { return HasAssociatedData(type); }
 		};
 
-		Tokenizer							tokenizer;
-		HashMap<string_view, IdentifierID>	identifiers;
+		// Thrown by Error once the diagnostic is recorded, caught where parsing can resume.
+		struct SyntaxError
+		{
+		};
+
+		// Parser state at the start of a statement or top-level item, restored by Recover.
+		struct RecoveryPoint
+		{
+			uintptr token;
+			uintptr operands;
+			uintptr operators;
+			uintptr scopes;
+		};
+
+		// Where a module path is written, as [offset, offset + size) of the source.
+		struct UsePath
+		{
+			uint32 offset;
+			uint32 size;
+		};
+
+		// The productions counted when built with ZERO_PARSER_PROFILE, named after the functions that parse them. The macro adds
+		// members to Parser, so it has to be defined for the whole build, not just one file.
+		enum class Production : uint8
+		{
+			ExpressionsUntil,
+			TokenSeparatedSequence,
+			ControlFlowExpressionBody,
+			Record,
+			ByUse,
+			ByNamespace,
+			Type,
+			ByEnum,
+			TypeDecl,
+			Branch,
+			Select,
+			While,
+			DoWhile,
+			For,
+			Scope,
+			Bracket,
+			Parenthesis,
+			FunctionBody,
+			Function,
+			Factors,
+			Operators,
+			Impl,
+			Next,
+			MaxEnum
+		};
+
+		// What the calls to one production took, the productions they called included. A production reached again while it is
+		// still being parsed, such as ParseImpl for a nested expression, is only measured at its outermost call, so nothing is
+		// counted twice; calls counts every one.
+		struct ProductionProfile
+		{
+			uint64 calls;
+			uint64 tokens;	// Consumed.
+			uint64 cycles;	// Time stamp counter ticks.
+			uint64 nodes;	// AST nodes allocated on this thread.
+			uint32 depth;	// Calls in progress.
+		};
+
+		struct PendingOperator
+		{
+			Operator	op;
+			uint8		precedence;
+			bool		unary;
+			uint32		offset;
+		};
+
+		TokenStream							tokens;
 		Module								this_module;
 		uintptr								ptr_size;
 		TokenInfo							this_token;
 		vector<Scope*>						scopes;
 		Scope*								this_scope;
+		vector<Expression>					operand_stack;	// Shared by nested ParseOperators calls, each one only pops what it pushed.
+		vector<PendingOperator>				operator_stack;
+		bool								defer_bodies;	// Skip braced function bodies, ParseDeferredBody parses one on demand.
+		uintptr								token_base;		// Index of the first token in the whole file, when parsing a slice of it.
+		std::function<void(string_view)>	on_use;			// Called with every module path as soon as its use is parsed.
+		vector<Diagnostic>					diagnostics;
+		uint32								max_diagnostics;	// Parsing stops once this many errors are recorded.
+		vector<ItemExtent>					item_extents;		// Of each item ParseFile put in the global scope, for Reparse.
+		vector<UsePath>						use_paths;			// Of every use parsed, dependencies holds the same paths.
+		uintptr								scanned;			// Furthest token looked at past this_token, by SkipBraces.
+		uintptr								item_first;			// Token the item being parsed starts at, a top-level one or a namespace element.
+		uint32								item_offset;		// Its byte offset, node offsets count from it so that edits before it never touch them.
+		uint64								deep_copies;		// AST nodes copied by the last ParseFile or Reparse, in debug builds.
+#ifdef ZERO_PARSER_PROFILE
+		std::array<ProductionProfile, (uintptr)Production::MaxEnum>	profile;	// Since construction or the last Reset.
+		FILE*								profile_out;		// Where ParseFile reports the profile, none if null.
+		bool								profile_json;		// Report it as JSON instead of a table.
+#endif
+
+		static constexpr uintptr MinParallelChunkTokens = 1 << 14;
+		static constexpr uint32 DefaultMaxDiagnostics = 100;
 
-		Parser() = default;
-		explicit Parser(string_view text);
+		Parser() : Parser(string_view()) {}
+		explicit Parser(string_view text, bool padded = false);
+		explicit Parser(const SourceFile& file) : Parser(file.Text(), true) {}
+		explicit Parser(TokenStream&& tokens, uintptr token_base = 0);
 		Parser(const Parser&) = default;
 		Parser& operator=(const Parser&) = default;
 		~Parser() = default;
 
 		IdentifierID		GetIdentifierID(string_view name);
 		void				Reset();
+		void				Reset(string_view text, bool padded = false);
+		void				Reset(const SourceFile& file) { Reset(file.Text(), true); }
 		void				Accept();
 		bool				Accept(TokenType type);
+		TokenType			Peek(uintptr k = 1) const;
+		uintptr				Tell() const;
+		void				Seek(uintptr index);
+		uint32				Offset() const;
+		uint32				NodeOffset() const;
+		SourceLocation		Locate(uint32 offset) const;
 		void				Expect(TokenType type, string_view message);
 		
 		template <typename T>
@@ -55,7 +171,15 @@ namespace Zero
 		}
 
 		[[noreturn]] void	Error(string_view message);
+		[[noreturn]] void	Error(uint32 offset, uint32 size, string_view message);
 		void				Assert(bool condition, string_view message);
+		RecoveryPoint		GetRecoveryPoint() const;
+		void				Unwind(const RecoveryPoint& point);
+		void				Recover(const RecoveryPoint& point, bool top_level);
+		void				ReportDiagnostics(FILE* out, string_view path = {}) const;
+#ifdef ZERO_PARSER_PROFILE
+		void				ReportProfile(FILE* out, bool json = false) const;
+#endif
 
 		void				EnterScope(Scope* scope);
 		void				LeaveScope();
@@ -86,10 +210,31 @@ namespace Zero
 		Scope				ParseScope();
 		Expression			ParseBracket();
 		Expression			ParseParenthesis();
+		uintptr				SkipBraces(uintptr index);
+		void				ParseFunctionBody(Function& function);
+		void				ParseDeferredBody(Function& function, uintptr item, uint32 element = 0);
 		Expression			ParseFunction(optional<Identifier> name = std::nullopt);
-		Expression			ParseFactors(Expression lhs);
+		Expression			ParseFactors(Expression lhs, bool operand = false);
+		void				PushOperand();
+		void				ReduceOperator();
+		Expression			ParseOperators(uintptr operator_base);
+		Expression			ParseImpl(bool operand = false);
 		Expression			Parse();
-		Module				ParseFile();
+		bool				ParseNext(Expression& out);
+		bool				ParseNextElement(Expression& out);
+		Module&				ParseFile();
+		Module&				ParseFileParallel(uint32 thread_count = 0);
+		const Module&		Reparse(string_view text, const TextEdit& edit, bool padded = false);
+
+		// Hands each top-level item to fn as soon as it is parsed, instead of collecting them in this_module. fn gets the item by
+		// rvalue, so it can process it and let it go before the next one is parsed.
+		template <typename F>
+		void ParseEach(F&& fn)
+		{
+			Expression e;
+			while (ParseNext(e))
+				fn(std::move(e));
+		}
 
 		template <typename T>
 		bool PopMany(std::tuple<TokenType, T*> first)
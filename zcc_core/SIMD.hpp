@@ -0,0 +1,88 @@
+#pragma once
+#include "Util.hpp"
+
+#if defined(__AVX2__)
+#define ZERO_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZERO_SIMD_SSE2
+#endif
+
+#if defined(ZERO_SIMD_AVX2) || defined(ZERO_SIMD_SSE2)
+#define ZERO_SIMD
+#include <immintrin.h>
+#endif
+
+
+
+namespace Zero
+{
+#ifdef ZERO_SIMD
+	namespace SIMD
+	{
+		// A block of consecutive source bytes. Every classification returns a bitmask with bit N set if byte N matches.
+		struct ByteBlock
+		{
+#ifdef ZERO_SIMD_AVX2
+			using VectorT = __m256i;
+#else
+			using VectorT = __m128i;
+#endif
+
+			static constexpr uintptr Size = sizeof(VectorT);
+			static constexpr uint32 FullMask = Size == 32 ? UINT32_MAX : (uint32)((UINT64_C(1) << Size) - 1);
+
+			VectorT value;
+
+			static ByteBlock Load(const char* data)
+			{
+#ifdef ZERO_SIMD_AVX2
+				return { _mm256_loadu_si256((const __m256i*)data) };
+#else
+				return { _mm_loadu_si128((const __m128i*)data) };
+#endif
+			}
+
+			uint32 Equal(char c) const
+			{
+#ifdef ZERO_SIMD_AVX2
+				return (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(value, _mm256_set1_epi8(c)));
+#else
+				return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_set1_epi8(c)));
+#endif
+			}
+
+			// Unsigned, inclusive byte range test: lo <= byte <= hi.
+			uint32 InRange(char lo, char hi) const
+			{
+#ifdef ZERO_SIMD_AVX2
+				auto x = _mm256_sub_epi8(value, _mm256_set1_epi8(lo));
+				auto m = _mm256_min_epu8(x, _mm256_set1_epi8((char)(hi - lo)));
+				return (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, m));
+#else
+				auto x = _mm_sub_epi8(value, _mm_set1_epi8(lo));
+				auto m = _mm_min_epu8(x, _mm_set1_epi8((char)(hi - lo)));
+				return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(x, m));
+#endif
+			}
+
+			// Bytes with the high bit set, i.e. non-ASCII.
+			uint32 HighBit() const
+			{
+#ifdef ZERO_SIMD_AVX2
+				return (uint32)_mm256_movemask_epi8(value);
+#else
+				return (uint32)_mm_movemask_epi8(value);
+#endif
+			}
+		};
+
+		// Mask of the bits below index n, n in [0, 32].
+		constexpr uint32 PrefixMask(uint32 n)
+		{
+			return n >= 32 ? UINT32_MAX : (UINT32_C(1) << n) - 1;
+		}
+	}
+#endif
+}
\ No newline at end of file
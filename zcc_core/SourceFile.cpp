@@ -0,0 +1,180 @@
+#include "SourceFile.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+
+namespace Zero
+{
+	static uintptr RoundUp(uintptr size, uintptr alignment)
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+
+	SourceFile::SourceFile() :
+		data(), size(), mapped_size(), copied()
+	{
+	}
+
+	SourceFile::SourceFile(SourceFile&& other) noexcept :
+		data(other.data), size(other.size), mapped_size(other.mapped_size), copied(other.copied)
+	{
+		other.data = nullptr;
+		other.size = 0;
+		other.mapped_size = 0;
+	}
+
+	SourceFile& SourceFile::operator=(SourceFile&& other) noexcept
+	{
+		this->~SourceFile();
+		new (this) SourceFile(std::move(other));
+		return *this;
+	}
+
+	SourceFile::~SourceFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool SourceFile::Open(const char* path)
+	{
+		Close();
+
+		auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		SYSTEM_INFO info = {};
+		GetSystemInfo(&info);
+		auto n = (uintptr)file_size.QuadPart;
+		auto total = RoundUp(n + SOURCE_PADDING, info.dwPageSize);
+
+		void* view = nullptr;
+		bool read = false;
+		if (n != 0 && total == RoundUp(n, info.dwPageSize))
+		{
+			// The rest of the last page is zero-filled and already holds the padding.
+			auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+		}
+		else
+		{
+			// A view can only be followed by zero pages at a fixed address through placeholder mappings (Windows 10 1803+),
+			// so files that end too close to a page boundary are read into fresh pages instead.
+			view = VirtualAlloc(nullptr, total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			read = true;
+			for (uintptr offset = 0; view != nullptr && offset != n;)
+			{
+				DWORD count = 0;
+				auto chunk = (DWORD)std::min<uintptr>(n - offset, UINT32_MAX);
+				if (!ReadFile(file, (char*)view + offset, chunk, &count, nullptr) || count == 0)
+				{
+					VirtualFree(view, 0, MEM_RELEASE);
+					view = nullptr;
+					break;
+				}
+				offset += count;
+			}
+		}
+		CloseHandle(file);
+
+		if (view == nullptr)
+			return false;
+
+		data = (const char*)view;
+		size = n;
+		mapped_size = total;
+		copied = read;
+		return true;
+	}
+
+	void SourceFile::Close()
+	{
+		if (data == nullptr)
+			return;
+		if (copied)
+			VirtualFree((void*)data, 0, MEM_RELEASE);
+		else
+			UnmapViewOfFile(data);
+		data = nullptr;
+		size = 0;
+		mapped_size = 0;
+	}
+#else
+	bool SourceFile::Open(const char* path)
+	{
+		Close();
+
+		auto fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat info = {};
+		if (fstat(fd, &info) != 0)
+		{
+			(void)close(fd);
+			return false;
+		}
+
+		auto page = (uintptr)sysconf(_SC_PAGESIZE);
+		auto n = (uintptr)info.st_size;
+		auto total = RoundUp(n + SOURCE_PADDING, page);
+
+		void* view = MAP_FAILED;
+		if (n != 0 && total == RoundUp(n, page))
+		{
+			// The rest of the last page is zero-filled and already holds the padding.
+			view = mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		else
+		{
+			// Reserve zero pages for the text and the padding, then overlay the file on the front of them.
+			view = mmap(nullptr, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (view != MAP_FAILED && n != 0 && mmap(view, n, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+			{
+				(void)munmap(view, total);
+				view = MAP_FAILED;
+			}
+		}
+		(void)close(fd);
+
+		if (view == MAP_FAILED)
+			return false;
+
+		data = (const char*)view;
+		size = n;
+		mapped_size = total;
+		copied = false;
+		return true;
+	}
+
+	void SourceFile::Close()
+	{
+		if (data == nullptr)
+			return;
+		(void)munmap((void*)data, mapped_size);
+		data = nullptr;
+		size = 0;
+		mapped_size = 0;
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include "Util.hpp"
+
+
+
+namespace Zero
+{
+	// Bytes of NUL padding guaranteed after the end of a SourceFile, enough for a full SIMD block or SWAR word past any byte of the text.
+	constexpr uintptr SOURCE_PADDING = 64;
+
+	// A read-only, memory-mapped view of a file. The text is never copied to the heap and is always followed by SOURCE_PADDING NUL bytes,
+	// so a Tokenizer constructed with padded = true can rely on the sentinel instead of checking for the end on every byte.
+	struct SourceFile
+	{
+		const char*	data;
+		uintptr		size;
+		uintptr		mapped_size;	// Bytes reserved at data, padding included.
+		bool		copied;			// The text was read into a private allocation instead of mapped.
+
+		SourceFile();
+		SourceFile(const SourceFile&) = delete;
+		SourceFile& operator=(const SourceFile&) = delete;
+		SourceFile(SourceFile&& other) noexcept;
+		SourceFile& operator=(SourceFile&& other) noexcept;
+		~SourceFile();
+
+		bool		Open(const char* path);
+		void		Close();
+
+		bool		IsOpen() const { return data != nullptr; }
+		string_view	Text() const { return string_view(data, size); }
+	};
+}
\ No newline at end of file
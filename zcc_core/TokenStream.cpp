@@ -0,0 +1,473 @@
+#include "TokenStream.hpp"
+#include <thread>
+
+
+
+namespace Zero
+{
+	TokenStream::TokenStream(string_view text, bool padded) :
+		types(), offsets(), sizes(), payloads(), literals(), identifiers(), source(), position(), lines(), strings()
+	{
+		Lex(text, padded);
+	}
+
+	// Appends the tokens that start before stop, the last one may run past it. Returns the index of the first reference token that
+	// starts where the next token would, as from there on both runs are identical, or SIZE_MAX if the runs never line up.
+	static uintptr LexUntil(TokenStream& out, Tokenizer& tokenizer, const char* stop, const TokenStream* reference = nullptr)
+	{
+		uintptr j = 0;
+		TokenData data;
+		tokenizer.identifiers = &out.identifiers;
+		while (true)
+		{
+			tokenizer.SkipCommentsAndWhitespace();
+			if (tokenizer.cursor >= stop)
+				return SIZE_MAX;
+
+			auto offset = (uint32)(tokenizer.cursor - tokenizer.begin);
+
+			if (reference != nullptr)
+			{
+				while (j != reference->Size() && reference->offsets[j] < offset)
+					++j;
+				if (j != reference->Size() && reference->offsets[j] == offset)
+					return j;
+			}
+
+			auto type = tokenizer.NextToken(data);
+			out.Push(type, offset, (uint32)(tokenizer.cursor - tokenizer.begin) - offset, data);
+		}
+	}
+
+	void TokenStream::Lex(string_view text, bool padded)
+	{
+		assert(text.size() <= UINT32_MAX);
+
+		Clear();
+		source = text;
+
+		auto reserve = text.size() / 4; // Rough guess, most tokens and their separators take a few bytes.
+		types.reserve(reserve);
+		offsets.reserve(reserve);
+		sizes.reserve(reserve);
+		payloads.reserve(reserve);
+
+		Tokenizer tokenizer(text, padded);
+		(void)LexUntil(*this, tokenizer, tokenizer.end);
+	}
+
+	namespace Detail
+	{
+		// One lexing pass over a chunk, assuming the previous chunk left the tokenizer at start.
+		struct ChunkRun
+		{
+			TokenStream tokens;
+			const char* start = nullptr;
+			const char* entry = nullptr;	// Where the first token starts, or where lexing stopped if there is none.
+			const char* resume = nullptr;	// Where the next chunk starts lexing.
+			uintptr join = SIZE_MAX;		// Index into the chunk's outside run where this run converged with it.
+
+			void Lex(string_view text, bool padded, const char* from, const char* stop, const ChunkRun* outside)
+			{
+				Tokenizer tokenizer(text, padded);
+				tokenizer.cursor = from;
+				tokenizer.SkipCommentsAndWhitespace();
+				start = from;
+				entry = tokenizer.cursor;
+				join = LexUntil(tokens, tokenizer, stop, outside != nullptr ? &outside->tokens : nullptr);
+				resume = join == SIZE_MAX ? tokenizer.cursor : outside->resume;
+			}
+		};
+
+		struct Chunk
+		{
+			const char* begin;
+			const char* end;
+			ChunkRun outside;
+			ChunkRun in_comment;	// Speculates that a block comment from an earlier chunk ends here.
+			ChunkRun in_string;		// Speculates that a string literal from an earlier chunk ends here.
+
+			void Lex(string_view text, bool padded)
+			{
+				outside.Lex(text, padded, begin, end, nullptr);
+
+				if (auto p = (const char*)memchr(begin, '`', end - begin); p != nullptr)
+					in_comment.Lex(text, padded, p + 1, end, &outside);
+
+				for (auto p = begin; p < end; ++p)
+				{
+					if (*p == '\\')
+					{
+						++p;
+					}
+					else if (*p == '\"')
+					{
+						in_string.Lex(text, padded, p + 1, end, &outside);
+						break;
+					}
+				}
+			}
+		};
+	}
+
+	void TokenStream::LexParallel(string_view text, uint32 thread_count, bool padded)
+	{
+		using Detail::Chunk;
+		using Detail::ChunkRun;
+
+		assert(text.size() <= UINT32_MAX);
+
+		if (thread_count == 0)
+			thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+		auto chunk_count = std::min<uintptr>(thread_count * 4, text.size() / MinParallelChunkSize);
+		if (thread_count == 1 || chunk_count < 2)
+		{
+			Lex(text, padded);
+			return;
+		}
+
+		// Chunks start right after a newline, so no identifier, number, operator or line comment straddles two of them.
+		vector<Chunk> chunks;
+		chunks.reserve(chunk_count);
+		auto text_end = text.data() + text.size();
+		auto prior = text.data();
+		for (uintptr i = 1; i <= chunk_count; ++i)
+		{
+			auto p = text.data() + text.size() * i / chunk_count;
+			if (i != chunk_count)
+			{
+				p = std::max(p, prior);
+				p = (const char*)memchr(p, '\n', text_end - p);
+				p = p != nullptr ? p + 1 : text_end;
+			}
+			if (p == prior)
+				continue;
+			auto& chunk = chunks.emplace_back();
+			chunk.begin = prior;
+			chunk.end = p;
+			prior = p;
+		}
+
+		std::atomic<uintptr> next_chunk = 0;
+		auto worker = [&]
+		{
+			for (auto i = next_chunk.fetch_add(1, std::memory_order_relaxed); i < chunks.size(); i = next_chunk.fetch_add(1, std::memory_order_relaxed))
+				chunks[i].Lex(text, padded);
+		};
+
+		vector<std::thread> threads;
+		threads.reserve(thread_count - 1);
+		for (uint32 i = 1; i != thread_count; ++i)
+			threads.emplace_back(worker);
+		worker();
+		for (auto& e : threads)
+			e.join();
+
+		// Stitch: follow the run each chunk actually starts in, as given by where the previous one stopped.
+		Clear();
+		source = text;
+
+		uintptr total = 0;
+		for (auto& e : chunks)
+			total += e.outside.tokens.Size();
+		types.reserve(total);
+		offsets.reserve(total);
+		sizes.reserve(total);
+		payloads.reserve(total);
+
+		auto resume = chunks.front().outside.entry;
+		for (auto& chunk : chunks)
+		{
+			if (resume >= chunk.end)
+				continue;
+
+			const ChunkRun* run = nullptr;
+			ChunkRun fallback;
+			for (auto e : { &chunk.outside, &chunk.in_comment, &chunk.in_string })
+			{
+				if (e->start != nullptr && e->entry == resume)
+				{
+					run = e;
+					break;
+				}
+			}
+			if (run == nullptr) // Neither guess was right, e.g. a char literal spanning lines. Lex from the real position until the runs line up.
+			{
+				fallback.Lex(text, padded, resume, chunk.end, &chunk.outside);
+				run = &fallback;
+			}
+
+			Append(run->tokens);
+			if (run->join != SIZE_MAX)
+				Append(chunk.outside.tokens, run->join);
+			resume = run->resume;
+		}
+	}
+
+	static bool HasLiteralSlot(TokenType type)
+	{
+		return type == TokenType::LiteralInt || type == TokenType::LiteralReal || type == TokenType::LiteralChar;
+	}
+
+	// Replaces removed elements of v at first by the ones in from.
+	template <typename T>
+	static void Splice(vector<T>& v, uintptr first, uintptr removed, const vector<T>& from)
+	{
+		auto common = std::min(removed, from.size());
+		std::copy(from.begin(), from.begin() + common, v.begin() + first);
+		if (removed > common)
+			v.erase(v.begin() + first + common, v.begin() + first + removed);
+		else
+			v.insert(v.begin() + first + common, from.begin() + common, from.end());
+	}
+
+	// Maps a view into the old source to the same bytes in the new one. Views that overlap the edited bytes are copied into storage,
+	// as the new text doesn't contain them.
+	static string_view Rebase(string_view view, string_view old_source, string_view new_source, const TextEdit& edit, StringArena& storage)
+	{
+		if (view.data() < old_source.data() || view.data() >= old_source.data() + old_source.size())
+			return view;
+		auto offset = (uint32)(view.data() - old_source.data());
+		if (offset + view.size() <= edit.offset)
+			return string_view(new_source.data() + offset, view.size());
+		if (offset >= edit.offset + edit.removed)
+			return string_view(new_source.data() + offset - edit.removed + edit.inserted, view.size());
+		return storage.Store(view);
+	}
+
+	// text is the whole source after the edit. It must not be the buffer the stream was lexed from, which has to stay unchanged until
+	// Relex returns: identifier names are views into it, and the ones that survive the edit are moved over.
+	TokenEdit TokenStream::Relex(string_view text, const TextEdit& edit, bool padded)
+	{
+		assert(text.size() <= UINT32_MAX);
+		assert(edit.offset + edit.removed <= source.size() && text.size() == source.size() - edit.removed + edit.inserted);
+
+		// A token that ends before the edit may still have looked at the bytes after it to decide where it ends, like 1 in 1.5 or < in
+		// <<=, so relexing starts one token earlier than the first token that reaches the edit. It resumes where the token before that
+		// one ended, as the comments and whitespace in between may be what was edited.
+		auto first = (uintptr)(std::lower_bound(offsets.begin(), offsets.end(), edit.offset) - offsets.begin());
+		if (first != 0 && offsets[first - 1] + sizes[first - 1] >= edit.offset)
+			--first;
+		if (first != 0)
+			--first;
+
+		// The old tokens after the edit, shifted by the edit delta, are where the new run may line up with the old one again.
+		auto old_end = edit.offset + edit.removed;
+		auto new_end = edit.offset + edit.inserted;
+		auto last = (uintptr)(std::lower_bound(offsets.begin() + first, offsets.end(), old_end) - offsets.begin());
+
+		Tokenizer tokenizer(text, padded);
+		tokenizer.identifiers = &identifiers;
+		tokenizer.cursor = tokenizer.begin + (first != 0 ? offsets[first - 1] + sizes[first - 1] : 0);
+
+		TokenStream fresh;
+		TokenData data;
+		while (true)
+		{
+			tokenizer.SkipCommentsAndWhitespace();
+			if (tokenizer.cursor >= tokenizer.end)
+			{
+				last = Size();
+				break;
+			}
+
+			auto offset = (uint32)(tokenizer.cursor - tokenizer.begin);
+			if (offset >= new_end)
+			{
+				while (last != Size() && offsets[last] - edit.removed + edit.inserted < offset)
+					++last;
+				if (last != Size() && offsets[last] - edit.removed + edit.inserted == offset)
+					break;
+			}
+
+			auto type = tokenizer.NextToken(data);
+			fresh.Push(type, offset, (uint32)(tokenizer.cursor - tokenizer.begin) - offset, data);
+		}
+
+		for (auto& e : identifiers.names)
+			e = Rebase(e, source, text, edit, identifiers.storage);
+
+		// New literals take the slots of the replaced ones first, so repeated edits don't grow literals.
+		vector<uint32> free_slots;
+		for (auto i = first; i != last; ++i)
+			if (HasLiteralSlot(types[i]))
+				free_slots.push_back(payloads[i]);
+		for (uintptr i = 0; i != fresh.Size(); ++i)
+		{
+			if (!HasLiteralSlot(fresh.types[i]))
+				continue;
+			auto& literal = fresh.literals[fresh.payloads[i]];
+			if (!free_slots.empty())
+			{
+				fresh.payloads[i] = free_slots.back();
+				literals[free_slots.back()] = std::move(literal);
+				free_slots.pop_back();
+			}
+			else
+			{
+				fresh.payloads[i] = (uint32)literals.size();
+				literals.push_back(std::move(literal));
+			}
+		}
+
+		auto removed = last - first;
+		Splice(types, first, removed, fresh.types);
+		Splice(offsets, first, removed, fresh.offsets);
+		Splice(sizes, first, removed, fresh.sizes);
+		Splice(payloads, first, removed, fresh.payloads);
+		if (auto delta = edit.inserted - edit.removed; delta != 0)
+			for (auto i = offsets.begin() + first + fresh.Size(); i != offsets.end(); ++i)
+				*i += delta; // Wraps around for deletions, as intended.
+
+		source = text;
+		lines.Clear();
+		Seek(position);
+		return { first, removed, fresh.Size() };
+	}
+
+	void TokenStream::Push(TokenType type, uint32 offset, uint32 size, const TokenData& data)
+	{
+		uint32 payload = 0;
+		switch (type)
+		{
+		case TokenType::Keyword:
+			payload = (uint32)data.Get<Keyword>();
+			break;
+		case TokenType::Operator:
+			payload = (uint32)data.Get<Operator>();
+			break;
+		case TokenType::Identifier:
+			payload = (uint32)data.Get<IdentifierID>();
+			break;
+		case TokenType::LiteralInt:
+		case TokenType::LiteralReal:
+		case TokenType::LiteralChar:
+			payload = (uint32)literals.size();
+			literals.push_back(data);
+			break;
+		case TokenType::LiteralString:
+			payload = data.Get<RawString>().escaped; // The text is the token's own, minus the quotes.
+			break;
+		default:
+			break;
+		}
+
+		types.push_back(type);
+		offsets.push_back(offset);
+		sizes.push_back(size);
+		payloads.push_back(payload);
+	}
+
+	void TokenStream::Append(const TokenStream& other, uintptr first)
+	{
+		for (auto i = first; i < other.Size(); ++i)
+		{
+			auto payload = other.payloads[i];
+			switch (other.types[i])
+			{
+			case TokenType::Identifier:
+			{
+				payload = (uint32)identifiers.Import(other.identifiers, (IdentifierID)payload);
+				break;
+			}
+			case TokenType::LiteralInt:
+			case TokenType::LiteralReal:
+			case TokenType::LiteralChar:
+				payload = (uint32)literals.size();
+				literals.push_back(other.literals[other.payloads[i]]);
+				break;
+			default:
+				break;
+			}
+			types.push_back(other.types[i]);
+			offsets.push_back(other.offsets[i]);
+			sizes.push_back(other.sizes[i]);
+			payloads.push_back(payload);
+		}
+	}
+
+	// Replaces the contents with tokens [first, last) of other, which keep their offsets into the same source and their identifier IDs.
+	// The names stay in other.identifiers, so a slice can be parsed on its own but interns nothing.
+	void TokenStream::Slice(const TokenStream& other, uintptr first, uintptr last)
+	{
+		assert(first <= last && last <= other.Size());
+
+		Clear();
+		source = other.source;
+		types.assign(other.types.begin() + first, other.types.begin() + last);
+		offsets.assign(other.offsets.begin() + first, other.offsets.begin() + last);
+		sizes.assign(other.sizes.begin() + first, other.sizes.begin() + last);
+		payloads.assign(other.payloads.begin() + first, other.payloads.begin() + last);
+		for (uintptr i = 0; i != types.size(); ++i)
+		{
+			switch (types[i])
+			{
+			case TokenType::LiteralInt:
+			case TokenType::LiteralReal:
+			case TokenType::LiteralChar:
+				literals.push_back(other.literals[payloads[i]]);
+				payloads[i] = (uint32)literals.size() - 1;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void TokenStream::Clear()
+	{
+		types.clear();
+		offsets.clear();
+		sizes.clear();
+		payloads.clear();
+		literals.clear();
+		identifiers.Clear();
+		source = {};
+		position = 0;
+		lines.Clear();
+		strings.Clear();
+	}
+
+	TokenData TokenStream::Data(uintptr index) const
+	{
+		switch (Type(index))
+		{
+		case TokenType::Keyword:
+			return (Keyword)payloads[index];
+		case TokenType::Operator:
+			return (Operator)payloads[index];
+		case TokenType::Identifier:
+			return (IdentifierID)payloads[index];
+		case TokenType::LiteralInt:
+		case TokenType::LiteralReal:
+		case TokenType::LiteralChar:
+			return literals[payloads[index]];
+		case TokenType::LiteralString:
+			return RawString{ source.substr(offsets[index] + 1, sizes[index] - 2), payloads[index] != 0 };
+		default:
+			return {};
+		}
+	}
+
+	SourceLocation TokenStream::Locate(uint32 offset) const
+	{
+		if (!lines.IsBuilt())
+			lines.Build(source);
+		return lines.Locate(offset);
+	}
+
+	string_view TokenStream::Text(uintptr index) const
+	{
+		if (index >= Size())
+			return {};
+		return source.substr(offsets[index], sizes[index]);
+	}
+
+	// Value of the LiteralString token at index. Only literals with escapes are decoded, into strings; false if an escape is malformed.
+	bool TokenStream::String(uintptr index, string_view& out) const
+	{
+		assert(Type(index) == TokenType::LiteralString);
+		return DecodeString(Data(index).Get<RawString>(), strings, out);
+	}
+}
\ No newline at end of file
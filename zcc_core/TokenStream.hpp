@@ -0,0 +1,77 @@
+#pragma once
+#include "Util.hpp"
+#include "Tokenizer.hpp"
+#include "LineIndex.hpp"
+
+
+
+namespace Zero
+{
+	// An edit to the source text: removed bytes at offset were replaced by inserted bytes.
+	struct TextEdit
+	{
+		uint32 offset;
+		uint32 removed;
+		uint32 inserted;
+	};
+
+	// The matching edit to a token stream: removed tokens at first were replaced by inserted tokens.
+	struct TokenEdit
+	{
+		uintptr first;
+		uintptr removed;
+		uintptr inserted;
+	};
+
+
+
+	// A whole file lexed up front, stored as parallel arrays so that any token can be inspected or revisited in O(1).
+	// LexParallel splits big files at newlines and lexes the chunks on worker threads, producing the same tokens as Lex.
+	// Pass padded = true for text that is followed by SOURCE_PADDING NUL bytes, such as a SourceFile, to lex without end checks.
+	// Relex updates the stream after an edit by lexing only the tokens around it, which costs about as much as the edit is long.
+	struct TokenStream
+	{
+		vector<TokenType>	types;
+		vector<uint32>		offsets;	// Byte offset of each token into source.
+		vector<uint32>		sizes;		// Byte size of each token.
+		vector<uint32>		payloads;	// Keyword/Operator value, IdentifierID, escaped flag of a string, or an index into literals for other literals.
+		vector<TokenData>	literals;
+		IdentifierTable		identifiers;
+		string_view			source;
+		uintptr				position;
+		mutable LineIndex	lines;		// Built by the first Locate call.
+		mutable StringArena	strings;	// Decoded string literals, filled by String.
+
+		TokenStream() = default;
+		explicit TokenStream(string_view text, bool padded = false);
+		TokenStream(const TokenStream&) = default;
+		TokenStream& operator=(const TokenStream&) = default;
+		~TokenStream() = default;
+
+		static constexpr uintptr MinParallelChunkSize = 1 << 20;
+
+		void		Lex(string_view text, bool padded = false);
+		void		LexParallel(string_view text, uint32 thread_count = 0, bool padded = false);
+		TokenEdit	Relex(string_view text, const TextEdit& edit, bool padded = false);
+		void		Clear();
+		void		Push(TokenType type, uint32 offset, uint32 size, const TokenData& data);
+		void		Append(const TokenStream& other, uintptr first = 0);
+		void		Slice(const TokenStream& other, uintptr first, uintptr last);
+
+		uintptr		Size() const { return types.size(); }
+		uintptr		Tell() const { return position; }
+		void		Seek(uintptr index) { position = std::min(index, Size()); }
+		void		Advance() { ++position; } // May move past the end, every token there reads as TokenType::MaxEnum.
+
+		TokenType	Type(uintptr index) const { return index < Size() ? types[index] : TokenType::MaxEnum; }
+		TokenData	Data(uintptr index) const;
+		string_view	Text(uintptr index) const;
+		bool		String(uintptr index, string_view& out) const;
+		uint32		Offset(uintptr index) const { return index < Size() ? offsets[index] : (uint32)source.size(); }
+
+		SourceLocation	Locate(uint32 offset) const;
+
+		TokenType	Peek(uintptr k = 0) const { return Type(position + k); }
+		TokenData	PeekData(uintptr k = 0) const { return Data(position + k); }
+	};
+}
\ No newline at end of file
@@ -1,9 +1,309 @@
 #include "Tokenizer.hpp"
+#include "SIMD.hpp"
+#include "SourceFile.hpp"
+#include "UTF8.hpp"
+#include <array>
+#include <cmath>
+#include <charconv>
 
 
 
 namespace Zero
 {
+	static constexpr uint8 CHAR_SPACE		= 1 << 0;
+	static constexpr uint8 CHAR_LETTER		= 1 << 1; // [A-Za-z_]
+	static constexpr uint8 CHAR_DIGIT		= 1 << 2;
+	static constexpr uint8 CHAR_HEX_DIGIT	= 1 << 3;
+	static constexpr uint8 CHAR_NON_ASCII	= 1 << 4; // Part of a UTF-8 sequence.
+
+	// Locale-independent replacement for the <cctype> classification functions.
+	static constexpr auto CHAR_FLAGS = []
+	{
+		std::array<uint8, 256> r = {};
+		for (uintptr i = 0; i != r.size(); ++i)
+		{
+			auto c = (char)i;
+			if (c == ' ' || (c >= '\t' && c <= '\r'))
+				r[i] |= CHAR_SPACE;
+			if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+				r[i] |= CHAR_LETTER;
+			if (c >= '0' && c <= '9')
+				r[i] |= CHAR_DIGIT | CHAR_HEX_DIGIT;
+			if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+				r[i] |= CHAR_HEX_DIGIT;
+			if (i >= 0x80)
+				r[i] |= CHAR_NON_ASCII;
+		}
+		return r;
+	}();
+
+	static bool IsSpace(char c) { return (CHAR_FLAGS[(uint8)c] & CHAR_SPACE) != 0; }
+	static bool IsLetter(char c) { return (CHAR_FLAGS[(uint8)c] & CHAR_LETTER) != 0; }
+	static bool IsDigit(char c) { return (CHAR_FLAGS[(uint8)c] & CHAR_DIGIT) != 0; }
+	static bool IsHexDigit(char c) { return (CHAR_FLAGS[(uint8)c] & CHAR_HEX_DIGIT) != 0; }
+	static bool IsAlphanumeric(char c) { return (CHAR_FLAGS[(uint8)c] & (CHAR_LETTER | CHAR_DIGIT)) != 0; }
+
+
+
+	// Longest-match DFA over OPERATOR_SPELLINGS. Bytes are first mapped to a column, so the transition table only spans the chars operators use.
+	struct OperatorDFA
+	{
+		static constexpr uintptr MaxStates = 64;
+		static constexpr uintptr MaxColumns = 32;
+
+		uint8 columns[256];						// 0 for bytes that never appear in an operator.
+		uint8 transitions[MaxStates][MaxColumns];	// 0 rejects, the start state is never re-entered.
+		uint8 accepts[MaxStates];				// 1 + index into OPERATOR_SPELLINGS, 0 if the state is not a complete token.
+		uint8 state_count;
+		uint8 column_count;
+	};
+
+	static constexpr auto OPERATOR_DFA = []
+	{
+		OperatorDFA r = {};
+		r.state_count = 1;
+		r.column_count = 1;
+		for (uint8 i = 0; i != std::size(OPERATOR_SPELLINGS); ++i)
+		{
+			uint8 state = 0;
+			for (auto c : OPERATOR_SPELLINGS[i].text)
+			{
+				auto& column = r.columns[(uint8)c];
+				if (column == 0)
+					column = r.column_count++;
+				auto& next = r.transitions[state][column];
+				if (next == 0)
+					next = r.state_count++;
+				state = next;
+			}
+			r.accepts[state] = i + 1;
+		}
+		return r;
+	}();
+
+	static_assert(OPERATOR_DFA.state_count <= OperatorDFA::MaxStates, "Too many operator prefixes, raise OperatorDFA::MaxStates.");
+	static_assert(OPERATOR_DFA.column_count <= OperatorDFA::MaxColumns, "Too many operator chars, raise OperatorDFA::MaxColumns.");
+
+
+
+	// Value of a digit in any radix up to 36, 0xFF for everything else.
+	static constexpr auto DIGIT_VALUES = []
+	{
+		std::array<uint8, 256> r = {};
+		for (uintptr i = 0; i != r.size(); ++i)
+		{
+			auto c = (char)i;
+			if (c >= '0' && c <= '9')
+				r[i] = (uint8)(c - '0');
+			else if (c >= 'a' && c <= 'z')
+				r[i] = (uint8)(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'Z')
+				r[i] = (uint8)(c - 'A' + 10);
+			else
+				r[i] = 0xFF;
+		}
+		return r;
+	}();
+
+	static constexpr auto POW10_INT = []
+	{
+		std::array<uint64, 20> r = {};
+		r[0] = 1;
+		for (uintptr i = 1; i != r.size(); ++i)
+			r[i] = r[i - 1] * 10;
+		return r;
+	}();
+
+	// Every entry is exact, 10^22 is the largest power of ten a double holds exactly.
+	static constexpr auto POW10_REAL = []
+	{
+		std::array<double, 23> r = {};
+		r[0] = 1;
+		for (uintptr i = 1; i != r.size(); ++i)
+			r[i] = r[i - 1] * 10;
+		return r;
+	}();
+
+	// 5^27 is the largest power of five below 2^63.
+	static constexpr auto POW5_INT = []
+	{
+		std::array<uint64, 28> r = {};
+		r[0] = 1;
+		for (uintptr i = 1; i != r.size(); ++i)
+			r[i] = r[i - 1] * 5;
+		return r;
+	}();
+
+	static uint64 LoadWord(const char* data)
+	{
+		uint64 r;
+		(void)memcpy(&r, data, sizeof(r));
+		return r;
+	}
+
+	// SWAR test for eight ASCII digits in a little-endian word.
+	static bool IsEightDigits(uint64 word)
+	{
+		return ((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+	}
+
+	// Converts eight ASCII digits with three multiplications: pairs, then quads, then the whole word.
+	static uint32 ParseEightDigits(uint64 word)
+	{
+		word -= 0x3030303030303030;
+		word = word * 10 + (word >> 8);
+		word = ((word & 0x000000FF000000FF) * (100 + (UINT64_C(1000000) << 32)) + ((word >> 16) & 0x000000FF000000FF) * (1 + (UINT64_C(10000) << 32))) >> 32;
+		return (uint32)word;
+	}
+
+	template <bool Padded>
+	static const char* SkipDigits(const char* cursor, const char* end)
+	{
+		while ((Padded || end - cursor >= 8) && IsEightDigits(LoadWord(cursor)))
+			cursor += 8;
+		while ((Padded || cursor != end) && IsDigit(*cursor))
+			++cursor;
+		return cursor;
+	}
+
+	// Returns false if the value doesn't fit in 64 bits.
+	static bool ParseDecimal(const char* first, const char* last, uint64& value)
+	{
+		while (first != last && *first == '0')
+			++first;
+		if (last - first > 20)
+			return false;
+		uint64 r = 0;
+		for (; last - first >= 8; first += 8)
+			r = r * 100000000 + ParseEightDigits(LoadWord(first));
+		for (; first != last; ++first)
+		{
+			auto digit = (uint64)(*first - '0');
+			if (r > (UINT64_MAX - digit) / 10)
+				return false;
+			r = r * 10 + digit;
+		}
+		value = r;
+		return true;
+	}
+
+	static BigInt ParseDecimalBig(const char* first, const char* last)
+	{
+		BigInt r;
+		for (; last - first >= 8; first += 8)
+			r.MulAdd(100000000, ParseEightDigits(LoadWord(first)));
+		for (; first != last; ++first)
+			r.MulAdd(10, (uint64)(*first - '0'));
+		return r;
+	}
+
+	// Returns false on a digit that is out of range for the radix.
+	static bool ParseRadix(const char* first, const char* last, uint32 radix, TokenData& out)
+	{
+		uint64 r = 0;
+		for (; first != last; ++first)
+		{
+			uint64 digit = DIGIT_VALUES[(uint8)*first];
+			if (digit >= radix)
+				return false;
+			uint64 high;
+			auto low = Multiply128(r, radix, high);
+			if (high != 0 || low + digit < low)
+				break;
+			r = low + digit;
+		}
+		if (first == last)
+		{
+			out = r;
+			return true;
+		}
+
+		BigInt big;
+		big.words.push_back(r);
+		for (; first != last; ++first)
+		{
+			uint64 digit = DIGIT_VALUES[(uint8)*first];
+			if (digit >= radix)
+				return false;
+			big.MulAdd(radix, digit);
+		}
+		out = std::move(big);
+		return true;
+	}
+
+#ifdef ZERO_HAS_DIVIDE128
+	// Correctly rounded w / 10^fraction, for fraction <= 27: the division by 5^fraction is done in 128 bits with a sticky remainder, the power of two is exact.
+	static double DivideExact(uint64 w, uint32 fraction)
+	{
+		auto divisor = POW5_INT[fraction];
+		auto quotient = [&](uint32 shift, uint64& remainder)
+		{
+			auto high = shift == 0 ? 0 : shift >= 64 ? w << (shift - 64) : w >> (64 - shift);
+			auto low = shift >= 64 ? 0 : w << shift;
+			return Divide128(high, low, divisor, remainder);
+		};
+
+		// Scale w so the quotient has exactly 64 significant bits.
+		auto shift = 63 + CountLeadingZeros(w) - CountLeadingZeros(divisor);
+		uint64 remainder;
+		auto q = quotient(shift, remainder);
+		if ((q >> 63) == 0)
+			q = quotient(++shift, remainder);
+
+		// Round to nearest even on the 11 bits below the mantissa, the remainder is the sticky bit.
+		auto mantissa = q >> 11;
+		auto rest = q & 0x7FF;
+		if (rest > 0x400 || (rest == 0x400 && (remainder != 0 || (mantissa & 1) != 0)))
+			++mantissa;
+		return std::ldexp((double)mantissa, 11 - (int)shift - (int)fraction);
+	}
+#endif
+
+	// Literals have no exponent, so the value is always w * 10^-fraction with w the digits without the dot.
+	static double ParseReal(const char* first, const char* dot, const char* last)
+	{
+		auto fraction = (uint32)(last - dot - 1);
+		auto int_first = first;
+		while (int_first != dot && *int_first == '0')
+			++int_first;
+		auto significant = (uintptr)(dot - int_first) + fraction;
+		if (int_first == dot)
+		{
+			auto frac_first = dot + 1;
+			while (frac_first != last && *frac_first == '0')
+				++frac_first;
+			significant = (uintptr)(last - frac_first);
+		}
+
+		if (significant <= 19)
+		{
+			uint64 int_part = 0, frac_part = 0;
+			(void)ParseDecimal(int_first, dot, int_part);
+			(void)ParseDecimal(dot + 1, last, frac_part);
+			auto w = int_part * POW10_INT[std::min<uintptr>(fraction, 19)] + frac_part;
+			if (w == 0)
+				return 0.0;
+			if (w <= (UINT64_C(1) << 53) && fraction < POW10_REAL.size())
+				return (double)w / POW10_REAL[fraction];
+#ifdef ZERO_HAS_DIVIDE128
+			if (fraction < POW5_INT.size())
+				return DivideExact(w, fraction);
+#endif
+		}
+
+		// Rare: more than 19 significant digits or a very long fraction.
+		double r = 0;
+		(void)std::from_chars(first, last, r);
+		return r;
+	}
+
+
+
+	static_assert(SOURCE_PADDING >= sizeof(uint64), "Padded digit scans load a word past the last digit.");
+#ifdef ZERO_SIMD
+	static_assert(SOURCE_PADDING >= SIMD::ByteBlock::Size, "Padded scans load a full block past the last byte.");
+#endif
+
 	bool Tokenizer::TryGet(char c)
 	{
 		if (cursor == end || *cursor != c)
@@ -12,349 +312,293 @@ namespace Zero
 		return true;
 	}
 
+	template <bool Padded>
 	void Tokenizer::SkipComment()
 	{
 		++cursor;
 		char terminator = '`';
-		if (cursor < end && *cursor == '`')
+		if ((Padded || cursor < end) && *cursor == '`')
+		{
 			terminator = '\n';
-		++cursor;
+			++cursor;
+		}
+#ifdef ZERO_SIMD
+		using SIMD::ByteBlock;
+		while ((uintptr)(end - cursor) >= ByteBlock::Size)
+		{
+			auto block = ByteBlock::Load(cursor);
+			auto stop = block.Equal(terminator);
+			cursor += stop != 0 ? CountTrailingZeros(stop) + 1 : (uint32)ByteBlock::Size; // Consume the terminator too.
+			if (stop != 0)
+				return;
+		}
+		if constexpr (Padded)
+		{
+			// The rest fits in one block, the padding makes it safe to load.
+			auto left = (uint32)(end - cursor);
+			auto block = ByteBlock::Load(cursor);
+			auto stop = block.Equal(terminator) & SIMD::PrefixMask(left);
+			cursor += stop != 0 ? CountTrailingZeros(stop) + 1 : left;
+			return;
+		}
+#endif
 		while (cursor < end && *cursor != terminator)
 			++cursor;
 		if (cursor < end)
 			++cursor;
 	}
 
+	template <bool Padded>
 	void Tokenizer::SkipWhitespace()
-    {
-		while (cursor < end && isspace(*cursor))
+	{
+#ifdef ZERO_SIMD
+		using SIMD::ByteBlock;
+		while (Padded || (uintptr)(end - cursor) >= ByteBlock::Size) // NUL is not a space, so a padded scan always stops at the end.
 		{
-			if (*cursor == '\t')
-				++tab_count;
-			else if (*cursor == '\n')
-			{
-				++line_count;
-				tab_count = 0;
-			}
-			++cursor;
+			auto block = ByteBlock::Load(cursor);
+			auto space = block.Equal(' ') | block.InRange('\t', '\r'); // Same set as isspace in the "C" locale.
+			auto stop = ~space & ByteBlock::FullMask;
+			cursor += stop != 0 ? CountTrailingZeros(stop) : (uint32)ByteBlock::Size;
+			if (stop != 0)
+				return;
 		}
-    }
+#endif
+		while ((Padded || cursor < end) && IsSpace(*cursor))
+			++cursor;
+	}
 
+	template <bool Padded>
 	void Tokenizer::SkipCommentsAndWhitespace()
 	{
 		while (true)
 		{
-			SkipWhitespace();
-			if (cursor == end)
+			SkipWhitespace<Padded>();
+			if (!Padded && cursor == end)
 				break;
 			if (*cursor != '`')
 				break;
-			SkipComment();
+			SkipComment<Padded>();
 		}
 	}
 
-	void Tokenizer::SkipIdentifier()
+	void Tokenizer::SkipCommentsAndWhitespace()
 	{
-		while (cursor < end && (isalnum(*cursor) || *cursor == '_'))
-			++cursor;
+		if (padded)
+			SkipCommentsAndWhitespace<true>();
+		else
+			SkipCommentsAndWhitespace<false>();
 	}
 
-	TokenType Tokenizer::TokenizeSign(TokenData& out)
+	// Returns the IdentifierHash of the skipped name. The inner loop is pure ASCII, a byte with the high bit set ends it and only then
+	// is a Unicode XID_Continue char decoded, so ASCII identifiers pay one extra compare per name.
+	template <bool Padded>
+	uint64 Tokenizer::SkipIdentifier(bool& ascii)
 	{
-		char a = *cursor;
-		++cursor;
-		switch (a)
+		auto h = IDENTIFIER_HASH_SEED;
+		ascii = true;
+		while (true)
 		{
-		case '=':
-			if (TryGet('='))
-				out = Operator::CompareEQ;
-			else if (TryGet('>'))
-				return TokenType::Arrow;
-			else
-				out = Operator::Assign;
-			return TokenType::Operator;
-		case '+':
-			if (TryGet('='))
-				out = Operator::AddAssign;
-			else if (TryGet('+'))
-				out = Operator::Increment;
-			else
-				out = Operator::Add;
-			return TokenType::Operator;
-		case '-':
-			if (TryGet('='))
-				out = Operator::SubAssign;
-			else if (TryGet('-'))
-				out = Operator::Decrement;
-			else
-				out = Operator::Sub;
-			return TokenType::Operator;
-		case '*':
-			if (TryGet('='))
-				out = Operator::MulAssign;
-			else
-				out = Operator::Mul;
-			return TokenType::Operator;
-		case '/':
-			if (TryGet('='))
-				out = Operator::DivAssign;
-			else
-				out = Operator::Div;
-			return TokenType::Operator;
-		case '%':
-			if (TryGet('='))
-				out = Operator::ModAssign;
-			else
-				out = Operator::Mod;
-			return TokenType::Operator;
-		case '&':
-			if (TryGet('='))
-				out = Operator::AndAssign;
-			else if (TryGet('&'))
-				out = Operator::BoolAnd;
-			else
-				out = Operator::And;
-			return TokenType::Operator;
-		case '|':
-			if (TryGet('='))
-				out = Operator::OrAssign;
-			else if (TryGet('|'))
-				out = Operator::BoolOr;
-			else
-				out = Operator::Or;
-			return TokenType::Operator;
-		case '^':
-			if (TryGet('='))
-				out = Operator::XorAssign;
-			else
-				out = Operator::Xor;
-			return TokenType::Operator;
-		case '~':
-			out = Operator::Complement;
-			return TokenType::Operator;
-		case '<':
-			if (TryGet('<'))
+			while ((Padded || cursor < end) && IsAlphanumeric(*cursor))
+				h = IdentifierHashStep(h, *cursor++);
+			if ((!Padded && cursor == end) || (uint8)*cursor < 0x80)
+				break;
+			char32_t c;
+			auto size = DecodeUTF8(cursor, end, c);
+			if (size == 0 || !IsXIDContinue(c))
+				break;
+			ascii = false;
+			for (; size != 0; --size)
+				h = IdentifierHashStep(h, *cursor++);
+		}
+		return IdentifierHashFinish(h);
+	}
+
+	// Moves the cursor onto the closing quote of a string or char literal. Only the quote and backslashes stop the scan, so the body is
+	// searched a SIMD block at a time and nothing is decoded. Returns false if the text ends first.
+	template <bool Padded>
+	bool Tokenizer::SkipQuoted(char quote, bool& escaped)
+	{
+		escaped = false;
+		while (true)
+		{
+#ifdef ZERO_SIMD
+			using SIMD::ByteBlock;
+			bool found = false;
+			while (!found && (uintptr)(end - cursor) >= ByteBlock::Size)
 			{
-				if (TryGet('<'))
-				{
-					if (TryGet('='))
-						out = Operator::RotateLeftAssign;
-					else
-						out = Operator::RotateLeft;
-				}
-				else if (TryGet('='))
-					out = Operator::ShiftLeftAssign;
-				else
-					out = Operator::ShiftLeft;
+				auto block = ByteBlock::Load(cursor);
+				auto stop = block.Equal(quote) | block.Equal('\\');
+				cursor += stop != 0 ? CountTrailingZeros(stop) : (uint32)ByteBlock::Size;
+				found = stop != 0;
 			}
-			else if (TryGet('='))
+			if (Padded && !found)
 			{
-				if (TryGet('>'))
-					out = Operator::CompareTW;
-				else
-					out = Operator::CompareLE;
+				// The rest fits in one block, the padding makes it safe to load.
+				auto left = (uint32)(end - cursor);
+				auto block = ByteBlock::Load(cursor);
+				auto stop = (block.Equal(quote) | block.Equal('\\')) & SIMD::PrefixMask(left);
+				cursor += stop != 0 ? CountTrailingZeros(stop) : left;
 			}
-			else
-				out = Operator::CompareLT;
-			return TokenType::Operator;
-		case '>':
-			if (TryGet('>'))
+#endif
+			while (cursor < end && *cursor != quote && *cursor != '\\')
+				++cursor;
+			if (cursor == end)
+				return false;
+			if (*cursor == quote)
+				return true;
+			escaped = true;
+			if (end - cursor < 2)
 			{
-				if (TryGet('>'))
-				{
-					if (TryGet('='))
-						out = Operator::RotateRightAssign;
-					else
-						out = Operator::RotateRight;
-				}
-				else if (TryGet('='))
-					out = Operator::ShiftRightAssign;
-				else
-					out = Operator::ShiftRight;
+				cursor = end;
+				return false;
 			}
-			else if (TryGet('='))
-				out = Operator::CompareGE;
-			else
-				out = Operator::CompareGT;
-			return TokenType::Operator;
-		case '!':
-			if (TryGet('='))
-				out = Operator::BoolNot;
-			else
-				out = Operator::CompareNE;
-			return TokenType::Operator;
-		case '?':
-			return TokenType::TraitsOf;
-		case '$':
-			return TokenType::Wildcard;
-		case '@':
-			return TokenType::Address;
-		case '#':
-			return TokenType::Hash;
+			cursor += 2; // The escaped char can't end the literal, even if it is the quote.
+		}
+	}
+
+	template <bool Padded>
+	TokenType Tokenizer::TokenizeSign(TokenData& out)
+	{
+		switch (*cursor)
+		{
 		case '\'':
 		{
-			auto b = cursor;
-			while (cursor < end)
-			{
-				if (*cursor == '\\')
-				{
-					++cursor;
-					if (cursor == end)
-						exit(EXIT_FAILURE);
-					if (*cursor == '\'')
-						continue;
-				}
-				else if (*cursor == '\'')
-					break;
-			}
-
-			if (cursor - b != 1)
-			{
+			auto b = ++cursor;
+			bool escaped;
+			if (!SkipQuoted<Padded>('\'', escaped))
 				return TokenType::MaxEnum;
-			}
-
-			out = (char32_t)*b;
+			auto e = cursor++;
+			char32_t c;
+			auto size = b == e ? 0 : escaped ? DecodeEscape(b, e, c) : DecodeUTF8(b, e, c);
+			if (size == 0 || b + size != e)
+				return TokenType::MaxEnum;
+			out = c;
 			return TokenType::LiteralChar;
 		}
 		case '\"':
 		{
-			auto b = cursor;
-			while (cursor < end)
-			{
-				if (*cursor == '\\')
-				{
-					++cursor;
-					if (cursor == end)
-						exit(EXIT_FAILURE);
-					if (*cursor == '\"')
-						continue;
-				}
-				else if (*cursor == '\"')
-					break;
-			}
-			out = string_view(b, cursor - b);
+			auto b = ++cursor;
+			bool escaped;
+			if (!SkipQuoted<Padded>('\"', escaped))
+				return TokenType::MaxEnum;
+			out = RawString{ string_view(b, cursor - b), escaped };
+			++cursor;
 			return TokenType::LiteralString;
 		}
-		case '(':
-			return TokenType::ParenLeft;
-		case ')':
-			return TokenType::ParenRight;
-		case '[':
-			return TokenType::BracketLeft;
-		case ']':
-			return TokenType::BracketRight;
-		case '{':
-			return TokenType::BraceLeft;
-		case '}':
-			return TokenType::BraceRight;
-		case '.':
-			out = Operator::MemberAccess;
-			return TokenType::Operator;
-		case ':':
-			return TokenType::Colon;
-		case ',':
-			return TokenType::Comma;
-		case ';':
-			return TokenType::Semicolon;
 		default:
-			return TokenType::MaxEnum;
+			break;
 		}
+
+		uint8 state = 0;
+		uint8 accept = 0;
+		auto token_end = cursor + 1;
+		for (auto i = cursor; Padded || i != end; ++i) // NUL has no column and rejects.
+		{
+			state = OPERATOR_DFA.transitions[state][OPERATOR_DFA.columns[(uint8)*i]];
+			if (state == 0)
+				break;
+			if (OPERATOR_DFA.accepts[state] != 0)
+			{
+				accept = OPERATOR_DFA.accepts[state];
+				token_end = i + 1;
+			}
+		}
+		cursor = token_end;
+
+		if (accept == 0)
+			return TokenType::MaxEnum;
+
+		auto& e = OPERATOR_SPELLINGS[accept - 1];
+		if (e.type == TokenType::Operator)
+			out = Operator(e.op);
+		return e.type;
 	}
 
+	template <bool Padded>
 	TokenType Tokenizer::TokenizeNonDecimal(char key, TokenData& out)
 	{
-		char buffer[256] = {};
-		int radix;
-		auto a = cursor;
+		uint32 radix;
 		switch (key)
 		{
 		case 'b': case 'B':
 			radix = 2;
-			while (cursor != end && (*cursor == '0' || *cursor == '1'))
-				++cursor;
 			break;
 		case 'x': case 'X':
 			radix = 16;
-			while (cursor != end && isxdigit(*cursor))
-				++cursor;
 			break;
 		case 'r': case 'R':
-			while (cursor != end && *cursor != ':')
-				++cursor;
-			memcpy(buffer, a, cursor - a);
+		{
+			auto a = cursor;
+			cursor = SkipDigits<Padded>(cursor, end);
+			uint64 value = 0;
+			if (cursor == end || *cursor != ':' || !ParseDecimal(a, cursor, value) || value < 2 || value > 36)
+				return TokenType::MaxEnum;
 			++cursor;
-			radix = strtoul(buffer, nullptr, 10);
 			a = cursor;
-			while (cursor != end && isalnum(*cursor))
+			while ((Padded || cursor != end) && IsAlphanumeric(*cursor))
 				++cursor;
-			break;
+			return ParseRadix(a, cursor, (uint32)value, out) ? TokenType::LiteralInt : TokenType::MaxEnum;
+		}
 		default:
 			return TokenType::MaxEnum;
 		}
-		auto token = string_view(a, cursor - a);
-		if (token.size() >= 256)
-			abort();
-		(void)memcpy(buffer, token.data(), token.size());
-		out = (uint64)strtoull(buffer, nullptr, radix);
+		auto a = cursor;
+		while ((Padded || cursor != end) && DIGIT_VALUES[(uint8)*cursor] < radix)
+			++cursor;
+		(void)ParseRadix(a, cursor, radix, out);
 		return TokenType::LiteralInt;
 	}
 
+	template <bool Padded>
 	TokenType Tokenizer::TokenizeNumeric(TokenData& out)
 	{
-		if (*cursor == '0' && isalpha(cursor[1]))
+		if (*cursor == '0' && (Padded || end - cursor > 1) && IsLetter(cursor[1]))
 		{
 			auto c = cursor[1];
 			cursor += 2;
-			return TokenizeNonDecimal(c, out);
+			return TokenizeNonDecimal<Padded>(c, out);
 		}
-		else
+
+		auto a = cursor;
+		cursor = SkipDigits<Padded>(cursor, end);
+		if ((!Padded && cursor == end) || *cursor != '.')
 		{
-			auto a = cursor;
-			bool dot = false;
-			for (; cursor != end; ++cursor)
-			{
-				if (*cursor == '.')
-				{
-					if (dot)
-						break;
-					dot = true;
-					continue;
-				}
-				if (!isdigit(*cursor))
-					break;
-			}
-			auto token = string_view(a, cursor - a);
-			if (token.size() >= 256)
-			{
-				abort();
-			}
-			char buffer[256];
-			(void)memcpy(buffer, token.data(), token.size());
-			buffer[token.size()] = '\0';
-			if (dot)
-			{
-				out = strtod(buffer, nullptr);
-				return TokenType::LiteralReal;
-			}
+			uint64 value;
+			if (ParseDecimal(a, cursor, value))
+				out = value;
 			else
-			{
-				out = (uint64)strtoull(buffer, nullptr, 10);
-				return TokenType::LiteralInt;
-			}
+				out = ParseDecimalBig(a, cursor);
+			return TokenType::LiteralInt;
 		}
+
+		auto dot = cursor;
+		cursor = SkipDigits<Padded>(cursor + 1, end);
+		out = ParseReal(a, dot, cursor);
+		return TokenType::LiteralReal;
 	}
 
+	template <bool Padded>
 	TokenType Tokenizer::TokenizeKeywordOrIdentifier(TokenData& out)
 	{
 		auto start = cursor;
-		SkipIdentifier();
+		bool ascii;
+		auto hash = SkipIdentifier<Padded>(ascii);
 		auto token = string_view(start, cursor - start);
-		auto kw = IsKeyword(token);
+		auto kw = ascii ? IsKeyword(token, hash) : Keyword::MaxEnum;
 		if (kw != Keyword::MaxEnum)
 		{
 			out = kw;
 			return TokenType::Keyword;
 		}
+		else if (identifiers != nullptr)
+		{
+			// Canonically equivalent spellings must intern to the same ID.
+			if (string normalized; !ascii && (normalized = NormalizeNFC(token)) != token)
+				out = identifiers->InternCopy(normalized, IdentifierHash(normalized));
+			else
+				out = identifiers->Intern(token, hash);
+			return TokenType::Identifier;
+		}
 		else
 		{
 			out = token;
@@ -362,18 +606,130 @@ namespace Zero
 		}
 	}
 
+	template <bool Padded>
+	TokenType Tokenizer::TokenizeUnicode(TokenData& out)
+	{
+		char32_t c;
+		auto size = DecodeUTF8(cursor, end, c);
+		if (size != 0 && IsXIDStart(c))
+			return TokenizeKeywordOrIdentifier<Padded>(out);
+		cursor += size != 0 ? size : 1;
+		return TokenType::MaxEnum;
+	}
+
+	template <bool Padded>
     TokenType Tokenizer::NextToken(TokenData& out)
     {
-		SkipCommentsAndWhitespace();
+		SkipCommentsAndWhitespace<Padded>();
 		if (cursor == end)
 			return TokenType::MaxEnum;
 
-		if (isalpha(*cursor) || *cursor == '_')
-			return TokenizeKeywordOrIdentifier(out);
+		auto flags = CHAR_FLAGS[(uint8)*cursor];
+		if (flags & CHAR_LETTER)
+			return TokenizeKeywordOrIdentifier<Padded>(out);
+		if (flags & CHAR_DIGIT)
+			return TokenizeNumeric<Padded>(out);
+		if (flags & CHAR_NON_ASCII)
+			return TokenizeUnicode<Padded>(out);
+		return TokenizeSign<Padded>(out);
+    }
 
-		if (isdigit(*cursor))
-			return TokenizeNumeric(out);
-		else
-			return TokenizeSign(out);
+    TokenType Tokenizer::NextToken(TokenData& out)
+    {
+		return padded ? NextToken<true>(out) : NextToken<false>(out);
     }
+
+	uint32 DecodeEscape(const char* text, const char* end, char32_t& out)
+	{
+		if (end - text < 2 || text[0] != '\\')
+			return 0;
+		switch (text[1])
+		{
+		case '0':	out = '\0'; return 2;
+		case 'a':	out = '\a'; return 2;
+		case 'b':	out = '\b'; return 2;
+		case 'f':	out = '\f'; return 2;
+		case 'n':	out = '\n'; return 2;
+		case 'r':	out = '\r'; return 2;
+		case 't':	out = '\t'; return 2;
+		case 'v':	out = '\v'; return 2;
+		case '\\':	out = '\\'; return 2;
+		case '\'':	out = '\''; return 2;
+		case '\"':	out = '\"'; return 2;
+		case 'x':
+		{
+			if (end - text < 4)
+				return 0;
+			auto high = DIGIT_VALUES[(uint8)text[2]];
+			auto low = DIGIT_VALUES[(uint8)text[3]];
+			if (high >= 16 || low >= 16)
+				return 0;
+			out = (char32_t)(high * 16 + low);
+			return 4;
+		}
+		case 'u':
+		{
+			// \u{X} with 1 to 6 hex digits.
+			if (end - text < 5 || text[2] != '{')
+				return 0;
+			auto first = text + 3;
+			auto last = first;
+			char32_t c = 0;
+			for (; last != end && *last != '}'; ++last)
+			{
+				auto digit = DIGIT_VALUES[(uint8)*last];
+				if (digit >= 16 || last - first == 6)
+					return 0;
+				c = c * 16 + digit;
+			}
+			if (last == end || last == first || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+				return 0;
+			out = c;
+			return (uint32)(last + 1 - text);
+		}
+		default:
+			return 0;
+		}
+	}
+
+	bool DecodeString(const RawString& literal, StringArena& arena, string_view& out)
+	{
+		if (!literal.escaped)
+		{
+			out = literal.text;
+			return true;
+		}
+
+		auto cursor = literal.text.data();
+		auto end = cursor + literal.text.size();
+		auto first = arena.Allocate(literal.text.size()); // No escape decodes to more bytes than its spelling.
+		auto last = first;
+		while (true)
+		{
+			auto escape = (const char*)memchr(cursor, '\\', end - cursor);
+			auto run = (escape != nullptr ? escape : end) - cursor;
+			(void)memcpy(last, cursor, run);
+			last += run;
+			cursor += run;
+			if (escape == nullptr)
+				break;
+
+			char32_t c;
+			auto size = DecodeEscape(cursor, end, c);
+			if (size == 0)
+			{
+				arena.Shrink(first, literal.text.size(), 0);
+				return false;
+			}
+			if (cursor[1] == 'x')
+				*last++ = (char)c; // Raw byte, not a code point.
+			else
+				last += EncodeUTF8(c, last);
+			cursor += size;
+		}
+
+		arena.Shrink(first, literal.text.size(), last - first);
+		out = string_view(first, last - first);
+		return true;
+	}
 }
\ No newline at end of file
@@ -37,38 +37,135 @@ namespace Zero
 
 
 
+	struct OperatorSpelling
+	{
+		string_view	text;
+		TokenType	type;
+		Operator	op = Operator::MaxEnum;
+	};
+
+	// Every token with a fixed spelling. The tokenizer builds its operator DFA from this table at compile time.
+	constexpr OperatorSpelling OPERATOR_SPELLINGS[] =
+	{
+		{ "=",		TokenType::Operator, Operator::Assign },
+		{ "+",		TokenType::Operator, Operator::Add },
+		{ "+=",		TokenType::Operator, Operator::AddAssign },
+		{ "-",		TokenType::Operator, Operator::Sub },
+		{ "-=",		TokenType::Operator, Operator::SubAssign },
+		{ "*",		TokenType::Operator, Operator::Mul },
+		{ "*=",		TokenType::Operator, Operator::MulAssign },
+		{ "/",		TokenType::Operator, Operator::Div },
+		{ "/=",		TokenType::Operator, Operator::DivAssign },
+		{ "%",		TokenType::Operator, Operator::Mod },
+		{ "%=",		TokenType::Operator, Operator::ModAssign },
+		{ "&",		TokenType::Operator, Operator::And },
+		{ "&=",		TokenType::Operator, Operator::AndAssign },
+		{ "|",		TokenType::Operator, Operator::Or },
+		{ "|=",		TokenType::Operator, Operator::OrAssign },
+		{ "^",		TokenType::Operator, Operator::Xor },
+		{ "^=",		TokenType::Operator, Operator::XorAssign },
+		{ "<<",		TokenType::Operator, Operator::ShiftLeft },
+		{ "<<=",	TokenType::Operator, Operator::ShiftLeftAssign },
+		{ ">>",		TokenType::Operator, Operator::ShiftRight },
+		{ ">>=",	TokenType::Operator, Operator::ShiftRightAssign },
+		{ "<<<",	TokenType::Operator, Operator::RotateLeft },
+		{ "<<<=",	TokenType::Operator, Operator::RotateLeftAssign },
+		{ ">>>",	TokenType::Operator, Operator::RotateRight },
+		{ ">>>=",	TokenType::Operator, Operator::RotateRightAssign },
+		{ "~",		TokenType::Operator, Operator::Complement },
+		{ "++",		TokenType::Operator, Operator::Increment },
+		{ "--",		TokenType::Operator, Operator::Decrement },
+		{ "==",		TokenType::Operator, Operator::CompareEQ },
+		{ "!=",		TokenType::Operator, Operator::CompareNE },
+		{ "<",		TokenType::Operator, Operator::CompareLT },
+		{ "<=",		TokenType::Operator, Operator::CompareLE },
+		{ ">",		TokenType::Operator, Operator::CompareGT },
+		{ ">=",		TokenType::Operator, Operator::CompareGE },
+		{ "<=>",	TokenType::Operator, Operator::CompareTW },
+		{ "!",		TokenType::Operator, Operator::BoolNot },
+		{ "&&",		TokenType::Operator, Operator::BoolAnd },
+		{ "||",		TokenType::Operator, Operator::BoolOr },
+		{ ".",		TokenType::Operator, Operator::MemberAccess },
+
+		{ "{",		TokenType::BraceLeft },
+		{ "}",		TokenType::BraceRight },
+		{ "[",		TokenType::BracketLeft },
+		{ "]",		TokenType::BracketRight },
+		{ "(",		TokenType::ParenLeft },
+		{ ")",		TokenType::ParenRight },
+		{ ",",		TokenType::Comma },
+		{ ":",		TokenType::Colon },
+		{ ";",		TokenType::Semicolon },
+		{ "?",		TokenType::TraitsOf },
+		{ "@",		TokenType::Address },
+		{ "=>",		TokenType::Arrow },
+		{ "$",		TokenType::Wildcard },
+		{ "#",		TokenType::Hash },
+	};
+
+
+
+	// A string literal as spelled between its quotes. Escapes are left in place, DecodeString resolves them when the value is needed.
+	struct RawString
+	{
+		string_view	text;
+		bool		escaped; // text contains at least one backslash.
+
+		bool operator==(const RawString& other) const
+		{
+			return text == other.text && escaped == other.escaped;
+		}
+
+		bool operator!=(const RawString& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	// Decodes the escape sequence at text, which starts with a backslash, into a code point, or a byte for \xHH.
+	// Returns its length in bytes, or 0 if it is malformed or truncated by end.
+	uint32 DecodeEscape(const char* text, const char* end, char32_t& out);
+
+	// Value of a string literal. A literal without escapes is returned as is, otherwise it is decoded into arena.
+	bool DecodeString(const RawString& literal, StringArena& arena, string_view& out);
+
 	using TokenData = TaggedUnion<
 		Keyword, Operator,
 		bool, uint64, double, char32_t,
-		string_view>;
+		string_view, BigInt, IdentifierID, RawString>;
 
 	struct Tokenizer
 	{
 		const char* cursor;
 		const char* end;
-		uintptr tab_count;
-		uintptr line_count;
 		const char* begin;
+		bool padded; // The text is followed by SOURCE_PADDING NUL bytes, as a SourceFile is, and the inner loops stop on that sentinel instead of checking end.
+		IdentifierTable* identifiers; // If set, identifiers are interned and produce an IdentifierID instead of their text.
 
 		Tokenizer() = default;
 		Tokenizer(const Tokenizer&) = default;
 		Tokenizer& operator=(const Tokenizer&) = default;
 		~Tokenizer() = default;
 
-		constexpr Tokenizer(string_view text) :
-			cursor(text.data()), end(text.data() + text.size()), tab_count(), line_count(), begin(cursor)
+		constexpr Tokenizer(string_view text, bool padded = false) :
+			cursor(text.data()), end(text.data() + text.size()), begin(cursor), padded(padded), identifiers()
 		{
 		}
 
 		bool TryGet(char c);
-		void SkipComment();
-		void SkipWhitespace();
 		void SkipCommentsAndWhitespace();
-		void SkipIdentifier();
-		TokenType TokenizeSign(TokenData& out);
-		TokenType TokenizeNonDecimal(char key, TokenData& out);
-		TokenType TokenizeNumeric(TokenData& out);
-		TokenType TokenizeKeywordOrIdentifier(TokenData& out);
 		TokenType NextToken(TokenData& out);
+
+		template <bool Padded> void SkipComment();
+		template <bool Padded> void SkipWhitespace();
+		template <bool Padded> void SkipCommentsAndWhitespace();
+		template <bool Padded> uint64 SkipIdentifier(bool& ascii);
+		template <bool Padded> bool SkipQuoted(char quote, bool& escaped);
+		template <bool Padded> TokenType TokenizeSign(TokenData& out);
+		template <bool Padded> TokenType TokenizeNonDecimal(char key, TokenData& out);
+		template <bool Padded> TokenType TokenizeNumeric(TokenData& out);
+		template <bool Padded> TokenType TokenizeKeywordOrIdentifier(TokenData& out);
+		template <bool Padded> TokenType TokenizeUnicode(TokenData& out);
+		template <bool Padded> TokenType NextToken(TokenData& out);
 	};
 }
\ No newline at end of file
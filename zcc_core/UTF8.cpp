@@ -0,0 +1,164 @@
+#include "UTF8.hpp"
+#include "SIMD.hpp"
+
+#include <dependencies/utf8proc/utf8proc.h>
+
+
+
+namespace Zero
+{
+	uint32 DecodeUTF8(const char* text, const char* end, char32_t& out)
+	{
+		auto lead = (uint8)text[0];
+		uint32 size;
+		char32_t c, min;
+		if (lead < 0x80)
+		{
+			out = lead;
+			return 1;
+		}
+		else if ((lead & 0xE0) == 0xC0)
+		{
+			size = 2;
+			c = lead & 0x1F;
+			min = 0x80;
+		}
+		else if ((lead & 0xF0) == 0xE0)
+		{
+			size = 3;
+			c = lead & 0x0F;
+			min = 0x800;
+		}
+		else if ((lead & 0xF8) == 0xF0)
+		{
+			size = 4;
+			c = lead & 0x07;
+			min = 0x10000;
+		}
+		else
+		{
+			return 0;
+		}
+
+		if ((uintptr)(end - text) < size)
+			return 0;
+		for (uint32 i = 1; i != size; ++i)
+		{
+			auto next = (uint8)text[i];
+			if ((next & 0xC0) != 0x80)
+				return 0;
+			c = (c << 6) | (next & 0x3F);
+		}
+		if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+			return 0;
+		out = c;
+		return size;
+	}
+
+	uint32 EncodeUTF8(char32_t c, char* out)
+	{
+		if (c < 0x80)
+		{
+			out[0] = (char)c;
+			return 1;
+		}
+		else if (c < 0x800)
+		{
+			out[0] = (char)(0xC0 | (c >> 6));
+			out[1] = (char)(0x80 | (c & 0x3F));
+			return 2;
+		}
+		else if (c < 0x10000)
+		{
+			out[0] = (char)(0xE0 | (c >> 12));
+			out[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+			out[2] = (char)(0x80 | (c & 0x3F));
+			return 3;
+		}
+		else
+		{
+			out[0] = (char)(0xF0 | (c >> 18));
+			out[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+			out[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+			out[3] = (char)(0x80 | (c & 0x3F));
+			return 4;
+		}
+	}
+
+	uintptr ValidateUTF8(string_view text)
+	{
+		auto begin = text.data();
+		auto cursor = begin;
+		auto end = begin + text.size();
+		while (cursor != end)
+		{
+#ifdef ZERO_SIMD
+			using SIMD::ByteBlock;
+			while ((uintptr)(end - cursor) >= ByteBlock::Size)
+			{
+				auto high = ByteBlock::Load(cursor).HighBit();
+				if (high != 0)
+				{
+					cursor += CountTrailingZeros(high);
+					break;
+				}
+				cursor += ByteBlock::Size;
+			}
+			if (cursor == end)
+				break;
+#endif
+			if ((uint8)*cursor < 0x80)
+			{
+				++cursor;
+				continue;
+			}
+			char32_t c;
+			auto size = DecodeUTF8(cursor, end, c);
+			if (size == 0)
+				return (uintptr)(cursor - begin);
+			cursor += size;
+		}
+		return text.size();
+	}
+
+	bool IsXIDStart(char32_t c)
+	{
+		switch (utf8proc_category((utf8proc_int32_t)c))
+		{
+		case UTF8PROC_CATEGORY_LU:
+		case UTF8PROC_CATEGORY_LL:
+		case UTF8PROC_CATEGORY_LT:
+		case UTF8PROC_CATEGORY_LM:
+		case UTF8PROC_CATEGORY_LO:
+		case UTF8PROC_CATEGORY_NL:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool IsXIDContinue(char32_t c)
+	{
+		switch (utf8proc_category((utf8proc_int32_t)c))
+		{
+		case UTF8PROC_CATEGORY_MN:
+		case UTF8PROC_CATEGORY_MC:
+		case UTF8PROC_CATEGORY_ND:
+		case UTF8PROC_CATEGORY_PC:
+			return true;
+		default:
+			return IsXIDStart(c);
+		}
+	}
+
+	string NormalizeNFC(string_view name)
+	{
+		utf8proc_uint8_t* normalized = nullptr;
+		auto size = utf8proc_map((const utf8proc_uint8_t*)name.data(), (utf8proc_ssize_t)name.size(), &normalized, (utf8proc_option_t)(UTF8PROC_STABLE | UTF8PROC_COMPOSE));
+		if (size < 0)
+			return string(name);
+		auto r = string((const char*)normalized, (uintptr)size);
+		free(normalized);
+		return r;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "Util.hpp"
+
+
+
+namespace Zero
+{
+	// Decodes the well-formed UTF-8 sequence at text: no overlong forms, surrogates or code points past U+10FFFF.
+	// Returns its length in bytes, or 0 if the bytes at text are malformed or truncated by end.
+	uint32		DecodeUTF8(const char* text, const char* end, char32_t& out);
+
+	// Writes the 1 to 4 byte encoding of c, which must be a valid code point, and returns its length.
+	uint32		EncodeUTF8(char32_t c, char* out);
+
+	// Offset of the first malformed byte, or text.size() if all of it is valid. Pure ASCII blocks are skipped a SIMD block at a time.
+	uintptr		ValidateUTF8(string_view text);
+
+	// Unicode identifiers as in UAX #31, by general category.
+	bool		IsXIDStart(char32_t c);
+	bool		IsXIDContinue(char32_t c);
+
+	// NFC form of name. Only used for identifiers with non-ASCII chars, every ASCII string is already normalized.
+	string		NormalizeNFC(string_view name);
+}
\ No newline at end of file
@@ -30,6 +30,93 @@ namespace Zero
 		return (HashT)h;
 	}
 
+	void BigInt::MulAdd(uint64 multiplier, uint64 addend)
+	{
+		auto carry = addend;
+		for (auto& e : words)
+		{
+			uint64 high;
+			auto low = Multiply128(e, multiplier, high);
+			e = low + carry;
+			carry = high + (e < low);
+		}
+		if (carry != 0)
+			words.push_back(carry);
+	}
+
+	uint32 BigInt::BitWidth() const
+	{
+		for (auto i = words.size(); i != 0; --i)
+			if (words[i - 1] != 0)
+				return (uint32)(i * 64) - CountLeadingZeros(words[i - 1]);
+		return 0;
+	}
+
+	char* StringArena::Allocate(uintptr size)
+	{
+		if (!blocks.empty() && blocks.back().size - used >= size)
+		{
+			auto r = blocks.back().data.get() + used;
+			used += size;
+			return r;
+		}
+
+		if (size > BlockSize / 4)
+		{
+			// Big strings get a block of their own, placed behind the one being filled so its free space isn't lost.
+			Block block = { shared_ptr<char[]>(new char[size]), size };
+			auto r = block.data.get();
+			blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1, std::move(block));
+			if (blocks.size() == 1)
+				used = size;
+			return r;
+		}
+
+		blocks.push_back({ shared_ptr<char[]>(new char[BlockSize]), BlockSize });
+		used = size;
+		return blocks.back().data.get();
+	}
+
+	void StringArena::Shrink(char* data, uintptr size, uintptr new_size)
+	{
+		assert(new_size <= size);
+		if (!blocks.empty() && data + size == blocks.back().data.get() + used)
+			used -= size - new_size;
+	}
+
+	string_view StringArena::Store(string_view text)
+	{
+		auto r = Allocate(text.size());
+		(void)memcpy(r, text.data(), text.size());
+		return string_view(r, text.size());
+	}
+
+	bool StringArena::Owns(const char* data) const
+	{
+		for (auto& e : blocks)
+			if (data >= e.data.get() && data < e.data.get() + e.size)
+				return true;
+		return false;
+	}
+
+	// Keeps one block to fill again, so an arena that is cleared and refilled, as by a reused parser, stops allocating. A block that a
+	// copy of the arena still refers to is left to that copy.
+	void StringArena::Clear()
+	{
+		auto kept = std::find_if(blocks.rbegin(), blocks.rend(), [](const Block& e) { return e.size == BlockSize && e.data.use_count() == 1; });
+		if (kept != blocks.rend())
+		{
+			if (kept != blocks.rbegin())
+				std::swap(*kept, blocks.back());
+			blocks.erase(blocks.begin(), blocks.end() - 1);
+		}
+		else
+		{
+			blocks.clear();
+		}
+		used = 0;
+	}
+
 	namespace OS
 	{
 		void* Malloc(size_t size)
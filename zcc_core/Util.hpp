@@ -10,6 +10,7 @@
 #include <atomic>
 #include <memory>
 #include <tuple>
+#include <utility>
 #include <variant>
 #include <optional>
 #include <algorithm>
@@ -18,6 +19,10 @@
 
 #include "dependencies/flat_hash_map/bytell_hash_map.hpp"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 
 
 
@@ -118,6 +123,152 @@ namespace Zero
 
 
 
+	inline uint32 PopCount(uint32 mask)
+	{
+#ifdef _MSC_VER
+		return __popcnt(mask);
+#else
+		return (uint32)__builtin_popcount(mask);
+#endif
+	}
+
+	inline uint32 CountTrailingZeros(uint32 mask) // mask must be non-zero.
+	{
+#ifdef _MSC_VER
+		unsigned long r;
+		(void)_BitScanForward(&r, mask);
+		return (uint32)r;
+#else
+		return (uint32)__builtin_ctz(mask);
+#endif
+	}
+
+	inline uint32 CountLeadingZeros(uint32 mask) // mask must be non-zero.
+	{
+#ifdef _MSC_VER
+		unsigned long r;
+		(void)_BitScanReverse(&r, mask);
+		return 31 - (uint32)r;
+#else
+		return (uint32)__builtin_clz(mask);
+#endif
+	}
+
+	inline uint32 CountLeadingZeros(uint64 mask) // mask must be non-zero.
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long r;
+		(void)_BitScanReverse64(&r, mask);
+		return 63 - (uint32)r;
+#elif defined(_MSC_VER)
+		auto high = (uint32)(mask >> 32);
+		return high != 0 ? CountLeadingZeros(high) : 32 + CountLeadingZeros((uint32)mask);
+#else
+		return (uint32)__builtin_clzll(mask);
+#endif
+	}
+
+	// Full 64x64 bit product, returns the low word.
+	inline uint64 Multiply128(uint64 lhs, uint64 rhs, uint64& high)
+	{
+#if defined(__SIZEOF_INT128__)
+		auto r = (unsigned __int128)lhs * rhs;
+		high = (uint64)(r >> 64);
+		return (uint64)r;
+#elif defined(_MSC_VER) && defined(_M_X64)
+		return _umul128(lhs, rhs, &high);
+#else
+		auto ll = (lhs & UINT32_MAX) * (rhs & UINT32_MAX);
+		auto lh = (lhs & UINT32_MAX) * (rhs >> 32);
+		auto hl = (lhs >> 32) * (rhs & UINT32_MAX);
+		auto hh = (lhs >> 32) * (rhs >> 32);
+		auto mid = (ll >> 32) + (lh & UINT32_MAX) + (hl & UINT32_MAX);
+		high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+		return (mid << 32) | (ll & UINT32_MAX);
+#endif
+	}
+
+#if defined(__SIZEOF_INT128__) || (defined(_MSC_VER) && _MSC_VER >= 1920 && defined(_M_X64))
+#define ZERO_HAS_DIVIDE128
+	// (high:low) / divisor. The quotient must fit in 64 bits, i.e. high < divisor.
+	inline uint64 Divide128(uint64 high, uint64 low, uint64 divisor, uint64& remainder)
+	{
+#if defined(__SIZEOF_INT128__)
+		auto n = (unsigned __int128)high << 64 | low;
+		remainder = (uint64)(n % divisor);
+		return (uint64)(n / divisor);
+#else
+		return _udiv128(high, low, divisor, &remainder);
+#endif
+	}
+#endif
+
+
+
+	// Unsigned integer of arbitrary width, least significant word first. Only integer literals that don't fit in 64 bits use it.
+	struct BigInt
+	{
+		vector<uint64> words;
+
+		void MulAdd(uint64 multiplier, uint64 addend);
+		uint32 BitWidth() const;
+
+		bool operator==(const BigInt& other) const
+		{
+			return words == other.words;
+		}
+
+		bool operator!=(const BigInt& other) const
+		{
+			return words != other.words;
+		}
+	};
+
+
+
+	// Bump allocator for text that is not a view into the source, such as decoded string literals. A copy shares the blocks written so
+	// far and starts a block of its own on its next allocation, so views handed out by either stay valid while one of them is alive.
+	struct StringArena
+	{
+		static constexpr uintptr BlockSize = 1 << 16;
+
+		struct Block
+		{
+			shared_ptr<char[]>	data;
+			uintptr				size;
+		};
+
+		vector<Block>	blocks; // The last one is the one being filled.
+		uintptr			used;
+
+		StringArena() :
+			blocks(), used()
+		{
+		}
+
+		StringArena(const StringArena& other) :
+			blocks(other.blocks), used(blocks.empty() ? 0 : blocks.back().size)
+		{
+		}
+
+		StringArena& operator=(const StringArena& other)
+		{
+			this->~StringArena();
+			new (this) StringArena(other);
+			return *this;
+		}
+
+		~StringArena() = default;
+
+		char*		Allocate(uintptr size);
+		void		Shrink(char* data, uintptr size, uintptr new_size); // Gives back the tail of the latest allocation.
+		string_view	Store(string_view text);
+		bool		Owns(const char* data) const;
+		void		Clear();
+	};
+
+
+
 	uint64						XXHash64(const void* data, uintptr size);
 	std::pair<uint64, uint64>	XXHash128(const void* data, uintptr size);
 
@@ -370,11 +521,15 @@ namespace Zero
 			std::atomic_uint32_t bump;
 		};
 
+		// Released nodes are kept in batches, chains linked by next whose first nodes are linked by next_batch.
 		struct Node
 		{
 			Node* next;
+			Node* next_batch;
 		};
 
+		static_assert(sizeof(T) >= sizeof(Node));
+
 		template <typename A, typename B = A>
 		struct MyPair
 		{
@@ -386,18 +541,57 @@ namespace Zero
 		std::atomic<MyPair<Block*, size_t>> head;
 
 		T* Acquire()
+		{
+			auto r = AcquireBatch();
+			if (r != nullptr)
+			{
+				if (r->next != nullptr)
+					ReleaseBatch(r->next);
+				return (T*)r;
+			}
+			uint32 count = 1;
+			return AcquireRun(count);
+		}
+
+		void Release(T* e)
+		{
+			auto n = (Node*)e;
+			n->next = nullptr;
+			ReleaseBatch(n);
+		}
+
+		// A chain of released nodes linked by next, or null if there are none.
+		Node* AcquireBatch()
 		{
 			while (true)
 			{
 				auto prior = free.load(std::memory_order_acquire);
 				if (prior.first == nullptr)
-					break;
-				decltype(prior) desired = { prior.first->next, prior.second + 1 };
+					return nullptr;
+				decltype(prior) desired = { prior.first->next_batch, prior.second + 1 };
 				if (free.compare_exchange_weak(prior, desired, std::memory_order_acquire, std::memory_order_relaxed))
-					return (T*)prior.first;
+					return prior.first;
 				//SPIN_WAIT
 			}
+		}
 
+		void ReleaseBatch(Node* first)
+		{
+			while (true)
+			{
+				auto prior = free.load(std::memory_order_acquire);
+				first->next_batch = prior.first;
+				decltype(prior) desired = { first, prior.second + 1 };
+				if (free.compare_exchange_weak(prior, desired, std::memory_order_release, std::memory_order_relaxed))
+					break;
+				//SPIN_WAIT
+			}
+		}
+
+		// count consecutive nodes that were never handed out, fewer if they are the last ones of a block.
+		T* AcquireRun(uint32& count)
+		{
+			count = std::min<uint32>(count, BlockCapacity - 1);
 			Block* prior_head = nullptr;
 			while (true)
 			{
@@ -407,17 +601,24 @@ namespace Zero
 				prior_head = i;
 				do
 				{
-					auto n = i->bump.fetch_add(1, std::memory_order_acquire);
+					auto n = i->bump.fetch_add(count, std::memory_order_acquire);
 					if (n < BlockCapacity)
+					{
+						if (n + count > BlockCapacity)
+						{
+							i->bump.fetch_sub(n + count - BlockCapacity, std::memory_order_relaxed);
+							count = BlockCapacity - n;
+						}
 						return (T*)i + n;
-					i->bump.fetch_sub(1, std::memory_order_relaxed);
+					}
+					i->bump.fetch_sub(count, std::memory_order_relaxed);
 					i = i->next;
 				} while (i != nullptr);
 			}
 
 			auto new_head = (Block*)OS::Malloc(BlockSize);
 			assert(new_head != nullptr);
-			new (&new_head->bump) std::atomic_uint32_t(2);
+			new (&new_head->bump) std::atomic_uint32_t(1 + count);
 			while (true)
 			{
 				auto prior = head.load(std::memory_order_acquire);
@@ -428,37 +629,127 @@ namespace Zero
 				//SPIN_WAIT
 			}
 		}
+	};
 
-		void Release(T* e)
+
+
+	namespace Detail
+	{
+#ifdef ZERO_PARSER_PROFILE
+		inline thread_local uint64 scoped_ptr_allocations = 0; // Of any type, for the parser profile.
+#endif
+		inline thread_local uint64 scoped_ptr_copies = 0; // Nodes deep-copied on this thread, counted in debug builds only.
+
+		// A deep copy that is meant, which scoped_ptr_copies leaves out so that only the ones made by accident show up there.
+		template <typename T>
+		T Clone(const T& value)
 		{
-			auto n = (Node*)e;
-			while (true)
-			{
-				auto prior = free.load(std::memory_order_acquire);
-				n->next = prior.first;
-				decltype(prior) desired = { n, prior.second + 1 };
-				if (free.compare_exchange_weak(prior, desired, std::memory_order_release, std::memory_order_relaxed))
-					break;
-				//SPIN_WAIT
-			}
+			auto copies = scoped_ptr_copies;
+			T r = value;
+			scoped_ptr_copies = copies;
+			return r;
 		}
-	};
+	}
 
 
 
+	// One pool per type, shared by all threads through a small cache per thread, so threads building ASTs side by side only take the
+	// pool's free list a batch at a time. A thread hands its cache back when it exits and blocks are never returned to the OS, so
+	// nodes outlive the thread that allocated them and the memory a finished worker freed is reused by the next one.
 	template <typename T>
 	struct ScopedPtrTraits
 	{
-		inline static SimpleObjectPool<T> allocator;
+		using Pool = SimpleObjectPool<T>;
+		using Node = typename Pool::Node;
+
+		static constexpr uint32 BatchSize = 256;
+
+		struct Cache
+		{
+			Node* free;		// Taken before the pool.
+			Node* full;		// A whole batch kept back, so that a thread alternating New and Release doesn't go to the pool.
+			uint32 count;	// Releases since free was last swapped out, less the nodes taken since.
+			bool closed;	// Once the thread handed the cache back, New and Release go straight to the pool.
+		};
+
+		// Hands the cache back when the thread exits. Cache itself stays trivial, so it can still be read after this ran.
+		struct CacheOwner
+		{
+			~CacheOwner()
+			{
+				auto& c = cache;
+				if (c.free != nullptr)
+					allocator.ReleaseBatch(c.free);
+				if (c.full != nullptr)
+					allocator.ReleaseBatch(c.full);
+				c = { nullptr, nullptr, 0, true };
+			}
+		};
+
+		inline static Pool allocator;
+		inline static thread_local Cache cache = {};
+		inline static thread_local CacheOwner owner;
 
 		static T* New()
 		{
-			return allocator.Acquire();
+#ifdef ZERO_PARSER_PROFILE
+			++Detail::scoped_ptr_allocations;
+#endif
+			auto& c = cache;
+			if (c.free == nullptr && !Refill(c))
+				return allocator.Acquire();
+			auto r = c.free;
+			c.free = r->next;
+			c.count -= c.count != 0;
+			return (T*)r;
 		}
 
 		static void Release(T* ptr)
 		{
-			allocator.Release(ptr);
+			auto& c = cache;
+			if (c.closed)
+			{
+				allocator.Release(ptr);
+				return;
+			}
+			if (c.free == nullptr)
+				(void)&owner; // Constructs it on this thread, so that the cache goes back even if the thread never called New.
+			auto n = (Node*)ptr;
+			n->next = c.free;
+			c.free = n;
+			if (++c.count != BatchSize)
+				return;
+			if (c.full != nullptr)
+				allocator.ReleaseBatch(c.full);
+			c.full = c.free;
+			c.free = nullptr;
+			c.count = 0;
+		}
+
+		static bool Refill(Cache& c)
+		{
+			if (c.closed)
+				return false;
+			(void)&owner;
+			c.count = 0;
+			if (c.full != nullptr)
+			{
+				c.free = c.full;
+				c.full = nullptr;
+				return true;
+			}
+			c.free = allocator.AcquireBatch();
+			if (c.free != nullptr)
+				return true;
+			auto count = BatchSize;
+			auto run = allocator.AcquireRun(count);
+			for (auto i = count; i-- != 0;)
+			{
+				auto n = (Node*)(run + i);
+				n->next = c.free;
+				c.free = n;
+			}
+			return true;
 		}
 	};
 
@@ -479,11 +770,15 @@ namespace Zero
 		{
 		}
 
+		// Copies the whole subtree, one node at a time. Prefer moving, or Clone where a copy is really meant.
 		ScopedPtr(const ScopedPtr& other) noexcept :
 			ptr(other.ptr != nullptr ? Traits::New() : nullptr)
 		{
-			if (other.ptr != nullptr)
-				new (ptr) T(*other.ptr);
+			if (other.ptr == nullptr)
+				return;
+			if constexpr (Build::IsDebug)
+				++Detail::scoped_ptr_copies;
+			new (ptr) T(*other.ptr);
 		}
 
 		ScopedPtr& operator=(const ScopedPtr& other) noexcept
@@ -510,6 +805,7 @@ namespace Zero
 		{
 			if (ptr != nullptr)
 			{
+				ptr->~T();
 				Traits::Release(ptr);
 				ptr = nullptr;
 			}
@@ -562,6 +858,11 @@ namespace Zero
 			new (r) T(std::forward<U>(params)...);
 			return ScopedPtr<T>(r);
 		}
+
+		ScopedPtr Clone() const
+		{
+			return Detail::Clone(*this);
+		}
 	};
 
 
@@ -1,37 +1,388 @@
 #include <zcc_core/AST.hpp>
 #include <zcc_core/Parser.hpp>
+#include <zcc_core/ModuleGraph.hpp>
+#include <zcc_core/SourceFile.hpp>
+#include "Sources.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
 
 
 
-std::string ReadFile(const char* path)
+// Checks that parser reported exactly the expected diagnostics, in source order as "line:column: message". name says what it parsed.
+uint32_t CheckDiagnostics(Zero::Parser& parser, const char* name, std::initializer_list<const char*> expected)
 {
-	std::string r = "";
-	FILE* file = nullptr;
-	fopen_s(&file, path, "rb");
-	if (file == nullptr)
-		return r;
-	fseek(file, 0, SEEK_END);
-	r.resize((size_t)ftell(file));
-	fseek(file, 0, SEEK_SET);
-	fread(&r[0], 1, r.size(), file);
-	fclose(file);
-	return r;
+	auto diagnostics = parser.diagnostics;
+	std::stable_sort(diagnostics.begin(), diagnostics.end(), [](const Zero::Diagnostic& a, const Zero::Diagnostic& b) { return a.offset < b.offset; });
+	std::vector<std::string> found;
+	for (auto& e : diagnostics)
+	{
+		auto location = parser.Locate(e.offset);
+		found.push_back(std::to_string(location.line) + ":" + std::to_string(location.column) + ": " + e.message);
+	}
+	if (std::equal(found.begin(), found.end(), expected.begin(), expected.end()))
+		return 0;
+	printf("%s: the diagnostics are not the expected ones:\n", name);
+	parser.ReportDiagnostics(stdout, name);
+	return 1;
 }
 
+// Parses the file at path and checks its diagnostics.
+uint32_t Test(const char* path, std::initializer_list<const char*> expected = {})
+{
+	Zero::SourceFile file;
+	if (!file.Open(path))
+	{
+		printf("%s: can't open the file.\n", path);
+		return 1;
+	}
+	auto parser = Zero::Parser(file);
+	parser.ParseFile();
+	return CheckDiagnostics(parser, path, expected);
+}
 
-
-uint32_t Test(const char* path)
+// Parses text and checks its diagnostics.
+uint32_t TestText(const char* text, std::initializer_list<const char*> expected = {})
 {
-	auto text = ReadFile(path);
 	auto parser = Zero::Parser(text);
-	auto root = parser.ParseFile();
-	return 0;
+	parser.ParseFile();
+	return CheckDiagnostics(parser, text, expected);
+}
+
+
+
+// Everything two parses of the same text must agree on, the AST by node kind and offset along with each deferred body's range,
+// the diagnostics, the dependencies and the item extents, the ones of namespace elements too. Also finds the functions whose bodies
+// are still deferred.
+struct Signature
+{
+	std::vector<uint64_t> nodes;
+	std::vector<std::string> diagnostics;
+	std::set<std::string> dependencies;
+	std::vector<uint64_t> extents;
+	std::vector<std::tuple<Zero::Function*, size_t, uint32_t>> deferred; // With where each one is, as ParseDeferredBody takes it.
+	size_t item = 0; // Of the top-level item being visited.
+	uint32_t element = 0; // The first token of the namespace element being visited, from the start of that item.
+
+	Signature(Zero::Parser& parser)
+	{
+		for (auto& e : parser.this_module.global_scope.expressions)
+		{
+			nodes.push_back(~0ULL);
+			(*this)(e);
+			++item;
+		}
+		for (auto& e : parser.diagnostics)
+			diagnostics.push_back(std::to_string(e.offset) + ":" + std::to_string(e.size) + ": " + e.message);
+		std::sort(diagnostics.begin(), diagnostics.end());
+		for (auto& e : parser.this_module.dependencies)
+			dependencies.emplace(e);
+		for (auto& e : parser.item_extents)
+			extents.push_back(((uint64_t)e.first << 32) | e.reach);
+	}
+
+	bool operator==(const Signature& other) const
+	{
+		return nodes == other.nodes && diagnostics == other.diagnostics && dependencies == other.dependencies && extents == other.extents;
+	}
+
+	void operator()(Zero::Expression& e)
+	{
+		nodes.push_back((uint64_t)e.offset << 8 | e.ID());
+		e.Visit([&](auto& node) { Children(node); });
+	}
+
+	void operator()(Zero::Type& e)
+	{
+		e.Visit([&](auto& node) { Children(node); });
+	}
+
+	template <typename T>
+	void operator()(Zero::ScopedPtr<T>& e)
+	{
+		if (e != nullptr)
+			(*this)(*e);
+	}
+
+	template <typename T>
+	void operator()(std::vector<T>& e)
+	{
+		for (auto& x : e)
+			(*this)(x);
+	}
+
+	template <typename T>
+	void Children(T&)
+	{
+	}
+
+	template <typename T>
+	void Children(Zero::ScopedPtr<T>& e)
+	{
+		if (e != nullptr)
+			Children(*e);
+	}
+
+	void Children(Zero::Type& e) { (*this)(e); }
+	void Children(Zero::Array& e) { (*this)(e.type); }
+	void Children(Zero::Tuple& e) { (*this)(e.types); }
+	void Children(Zero::FunctionType& e) { (*this)(e.return_type); (*this)(e.param_types); }
+	void Children(Zero::Use& e) { (*this)(e.modules); }
+	void Children(Zero::Declaration& e) { (*this)(e.type); (*this)(e.init); }
+	void Children(Zero::Cast& e) { (*this)(e.value); (*this)(e.new_type); }
+	void Children(Zero::FunctionCall& e) { (*this)(e.callable); (*this)(e.params); }
+	void Children(Zero::Scope& e) { (*this)(e.expressions); (*this)(e.deferred); }
+	void Children(Zero::Branch& e) { (*this)(e.condition); (*this)(e.on_true); (*this)(e.on_false); }
+	void Children(Zero::While& e) { (*this)(e.condition); (*this)(e.body); }
+	void Children(Zero::DoWhile& e) { (*this)(e.condition); (*this)(e.body); }
+	void Children(Zero::For& e) { (*this)(e.init); (*this)(e.condition); (*this)(e.update); (*this)(e.body); }
+	void Children(Zero::ForEach& e) { (*this)(e.iterator); (*this)(e.collection); (*this)(e.body); }
+	void Children(Zero::UnaryExpression& e) { (*this)(e.other); }
+	void Children(Zero::BinaryExpression& e) { (*this)(e.lhs); (*this)(e.rhs); }
+	void Children(Zero::Defer& e) { (*this)(e.body); }
+	void Children(Zero::Return& e) { (*this)(e.value); }
+	void Children(Zero::Yield& e) { (*this)(e.value); }
+	void Children(Zero::TraitsOf& e) { (*this)(e.value); }
+	void Children(Zero::ConstructorCall& e) { (*this)(e.object); (*this)(e.parameters); }
+	void Children(Zero::DestructorCall& e) { (*this)(e.object); }
+
+	void Children(Zero::Enum& e)
+	{
+		for (auto& [name, value] : e.values)
+			(*this)(value);
+		(*this)(e.underlying_type);
+	}
+
+	void Children(Zero::Record& e)
+	{
+		for (auto& field : e.fields)
+			Children(field);
+	}
+
+	void Children(Zero::Namespace& e)
+	{
+		auto outer = element;
+		for (size_t i = 0; i != e.elements.size(); ++i)
+		{
+			nodes.push_back((uint64_t)e.extents[i].first << 32 | e.extents[i].reach);
+			element = outer + e.extents[i].first;
+			(*this)(e.elements[i]);
+		}
+		element = outer;
+		nodes.push_back((uint64_t)e.last << 32 | e.reach);
+	}
+
+	void Children(Zero::Function& e)
+	{
+		(*this)(e.body);
+		(*this)(e.return_type);
+		(*this)(e.params);
+		if (e.HasDeferredBody())
+		{
+			nodes.push_back((uint64_t)e.body_first << 32 | e.body_last);
+			deferred.emplace_back(&e, item, element);
+		}
+	}
+
+	void Children(Zero::Select& e)
+	{
+		(*this)(e.key);
+		for (auto& [key, value] : e.cases)
+		{
+			(*this)(const_cast<Zero::Expression&>(key)); // Offsets take no part in hashing or comparing keys.
+			(*this)(value);
+		}
+		(*this)(e.default_case);
+	}
+};
+
+
+
+// Checks that ParseFileParallel builds the same module as ParseFile, on a file big enough to be split and with items whose ; at
+// depth zero doesn't end them, like a for header, and an error that a chunk boundary must not move.
+uint32_t TestParallel()
+{
+	using Zero::Test::SourceItem;
+	std::mt19937 rng(7);
+	auto kinds = { SourceItem::Function, SourceItem::Declaration, SourceItem::For, SourceItem::Namespace, SourceItem::ForDo, SourceItem::Comment };
+	auto source = Zero::Test::MakeSource(rng, kinds, 3000);
+	source += Zero::Test::MakeSourceItem(SourceItem::Error, 0);
+	source += Zero::Test::MakeSource(rng, kinds, 3000);
+
+	uint32_t failures = 0;
+	for (auto defer_bodies : { false, true })
+	{
+		Zero::Parser sequential(source);
+		sequential.defer_bodies = defer_bodies;
+		sequential.ParseFile();
+		Zero::Parser parallel(source);
+		parallel.defer_bodies = defer_bodies;
+		parallel.ParseFileParallel(4);
+		if (Signature(sequential) == Signature(parallel))
+			continue;
+		printf("ParseFileParallel%s: the module differs from ParseFile's.\n", defer_bodies ? " with deferred bodies" : "");
+		++failures;
+	}
+	return failures;
+}
+
+
+
+// Checks that parsing every deferred body on demand, in namespaces and function literals too, builds the module an eager parse does.
+uint32_t TestDeferredBodies()
+{
+	using Zero::Test::SourceItem;
+	std::mt19937 rng(7);
+	auto source = Zero::Test::MakeSource(rng, { SourceItem::Function, SourceItem::Namespace, SourceItem::FunctionLiteral }, 150);
+
+	Zero::Parser eager(source);
+	eager.ParseFile();
+	Zero::Parser deferred(source);
+	deferred.defer_bodies = true;
+	deferred.ParseFile();
+
+	auto functions = Signature(deferred).deferred;
+	for (auto [function, item, element] : functions)
+		deferred.ParseDeferredBody(*function, item, element);
+	if (!functions.empty() && Signature(deferred) == Signature(eager))
+		return 0;
+	printf("ParseDeferredBody: %zu bodies were deferred, parsing them doesn't build the module ParseFile does.\n", functions.size());
+	return 1;
+}
+
+
+
+// Checks that Reparse after random edits leaves the module ParseFile would build from the edited text, kept items included. The
+// edits break and mend items, add and remove uses, write bodies and declarations whose types depend on names and move everything
+// after them. The same runs again with the whole file in one namespace, whose elements Reparse replaces one by one.
+uint32_t TestReparse()
+{
+	using Zero::Test::SourceItem;
+	auto kinds =
+	{
+		SourceItem::Function, SourceItem::Statements, SourceItem::Namespace, SourceItem::Comment, SourceItem::Use, SourceItem::Use,
+		SourceItem::Error, SourceItem::Group
+	};
+	const char* inserts[] =
+	{
+		"1", " + 2", ";", "}", "{", "x", "use e.f;\n", "\n", "(", ")", "`", "f(): { return 2 }\n", "g(): x\n", " return x ", "let y = x;\n", ""
+	};
+
+	uint32_t failures = 0;
+	for (auto [wrapped, defer_bodies] : { std::pair(false, false), std::pair(false, true), std::pair(true, false), std::pair(true, true) })
+	{
+		std::mt19937 rng(7);
+		std::string header = wrapped ? "namespace All {\n" : "";
+		std::string footer = wrapped ? "}\n" : "";
+		auto source = header + Zero::Test::MakeSource(rng, kinds, 40) + footer;
+		auto buffer = std::make_unique<std::string>(source);
+		Zero::Parser parser(*buffer);
+		parser.defer_bodies = defer_bodies;
+		parser.ParseFile();
+		for (uint32_t i = 0; i != 1000; ++i)
+		{
+			auto end = (uint32_t)(buffer->size() - footer.size());
+			auto offset = (uint32_t)(header.size() + rng() % (end - header.size() + 1));
+			auto removed = rng() % 3 != 0 ? std::min((uint32_t)(rng() % 6), end - offset) : 0;
+			std::string inserted = inserts[rng() % std::size(inserts)];
+			if (wrapped && i % 50 == 49)
+			{
+				// The edits soon break a brace of the namespace, so the text goes back to the start now and then.
+				offset = 0;
+				removed = (uint32_t)buffer->size();
+				inserted = source;
+			}
+			auto next = std::make_unique<std::string>(buffer->substr(0, offset) + inserted + buffer->substr(offset + removed));
+			parser.Reparse(*next, { offset, removed, (uint32_t)inserted.size() });
+			buffer = std::move(next);
+
+			Zero::Parser fresh(*buffer);
+			fresh.defer_bodies = defer_bodies;
+			fresh.ParseFile();
+			if (Signature(parser) == Signature(fresh))
+				continue;
+			printf("Reparse%s%s: the module differs from ParseFile's after edit %u.\n", wrapped ? " in a namespace" : "", defer_bodies ? " with deferred bodies" : "", i);
+			++failures;
+			break;
+		}
+	}
+	return failures;
+}
+
+
+
+// Checks ModuleGraph on the modules in Modules: the root uses a and b, which both use c, c uses a again and b uses a module that
+// doesn't exist. Every module must be parsed once and the critical path must follow imports without running around the cycle.
+uint32_t TestModuleGraph()
+{
+	const std::map<std::string, std::vector<std::string>> expected =
+	{
+		{ "", { "a", "b" } },
+		{ "a", { "c" } },
+		{ "b", { "c", "d.e", "missing" } },
+		{ "c", { "a" } },
+		{ "d.e", {} },
+		{ "missing", {} },
+	};
+
+	uint32_t failures = 0;
+	for (uint32_t threads : { 1, 4 })
+	{
+		Zero::ModuleGraph graph;
+		auto complete = graph.Parse("Modules/root.zero", threads);
+
+		std::map<std::string, std::vector<std::string>> imports;
+		auto resolved = true;
+		for (auto& node : graph.nodes)
+		{
+			auto& e = imports[node.name];
+			for (auto id : node.imports)
+				e.push_back(graph.nodes[id].name);
+			resolved &= node.path.empty() == (node.name == "missing");
+		}
+
+		auto path = graph.CriticalPath();
+		auto chain = !path.empty() && path[0] == 0 && std::set<uint32_t>(path.begin(), path.end()).size() == path.size();
+		for (size_t i = 1; i < path.size(); ++i)
+		{
+			auto& e = graph.nodes[path[i - 1]].imports;
+			chain &= std::find(e.begin(), e.end(), path[i]) != e.end();
+		}
+
+		if (!complete && graph.nodes.size() == expected.size() && imports == expected && resolved && chain)
+			continue;
+		printf("ModuleGraph with %u threads: the graph of Modules/root.zero is not the expected one.\n", threads);
+		graph.Report(stdout);
+		++failures;
+	}
+	return failures;
 }
 
 
 
 int main(int argc, char** args)
 {
-	Test("ControlFlow.txt");
-	return 0;
+	uint32_t failures = 0;
+	failures += Test("ControlFlow.txt");
+
+	// Types that depend on names are left out, not inferred, and can't make return types ambiguous.
+	failures += TestText("let a = b;");
+	failures += TestText("f(): x");
+	failures += TestText("f(): { return x }");
+	failures += TestText("f(): { return 1; return x }");
+	failures += TestText("f(): { return 1; return true }", { "1:31: Ambiguous function return type." });
+	failures += TestDeferredBodies();
+	failures += TestParallel();
+	failures += TestReparse();
+	failures += TestModuleGraph();
+
+	if (failures != 0)
+		printf("%u tests failed.\n", failures);
+	return failures != 0 ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <zcc_core/Util.hpp>
+#include <initializer_list>
+#include <string>
+
+
+
+// Generated sources shared by the tests and the benches, so that both parse the same shapes of items.
+namespace Zero::Test
+{
+	enum class SourceItem : uint8
+	{
+		Function,			// A braced body with operators, a branch and a return.
+		Declaration,
+		Namespace,			// Functions in it and in a nested namespace.
+		Comment,			// Holds a } and a ;, which must not end anything, before a function with a loop.
+		For,				// The ; in its header don't end the item.
+		ForDo,
+		Statements,			// Two on one line.
+		Use,
+		Error,				// Assigns nothing.
+		Group,				// A parenthesized operand.
+		FunctionLiteral,	// Returning another one.
+		MaxEnum
+	};
+
+	// The text of one top-level item, ending in a line break. Names end with n, so items of the same kind can be told apart.
+	inline string MakeSourceItem(SourceItem kind, uint32 n)
+	{
+		auto s = std::to_string(n);
+		switch (kind)
+		{
+		case SourceItem::Function:
+			return "f" + s + "(): { x = 1 + 2 * 3; if x do g() else h(); return 4 }\n";
+		case SourceItem::Declaration:
+			return "let v" + s + " = " + s + "\n";
+		case SourceItem::Namespace:
+			return "namespace N" + s + " { k(): { return 1 } namespace M { j(): { k(); return 2 } } }\n";
+		case SourceItem::Comment:
+			return "` comment } ; `\nmain" + s + "(): { while true { } }\n";
+		case SourceItem::For:
+			return "for int j = 0; j != n; j = j + 1 { y = a + b * c; z = -d }\n";
+		case SourceItem::ForDo:
+			return "for int i = 0; i != 10; i = i + 1 do x = i\n";
+		case SourceItem::Statements:
+			return "y = a + b * c; z = -d\n";
+		case SourceItem::Use:
+			return "use a" + s + ".b;\n";
+		case SourceItem::Error:
+			return "x = ;\n";
+		case SourceItem::Group:
+			return "q = (a)\n";
+		case SourceItem::FunctionLiteral:
+			return "v" + s + " = (a): { return (): { return 3 } }\n";
+		default:
+			return {};
+		}
+	}
+
+	// count items of the given kinds, each picked by rng and numbered by its position.
+	template <typename R>
+	string MakeSource(R& rng, std::initializer_list<SourceItem> kinds, uint32 count)
+	{
+		string r;
+		for (uint32 i = 0; i != count; ++i)
+			r += MakeSourceItem(kinds.begin()[rng() % kinds.size()], i);
+		return r;
+	}
+}
\ No newline at end of file